@@ -1,36 +1,49 @@
-cirGate.o: cirGate.cpp cirGate.h cirDef.h ../../include/myHashMap.h \
- ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
- ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
- ../../include/Proof.h ../../include/File.h cirMgr.h ../../include/util.h \
- ../../include/rnGen.h ../../include/myUsage.h
-cirSim.o: cirSim.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
+cirAig.o: cirAig.cpp cirAig.h cirDef.h ../../include/myHashMap.h \
  cirGate.h ../../include/sat.h ../../include/Solver.h \
  ../../include/SolverTypes.h ../../include/Global.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
- ../../include/File.h ../../include/util.h ../../include/rnGen.h \
- ../../include/myUsage.h
-cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
- cirGate.h ../../include/sat.h ../../include/Solver.h \
+ ../../include/File.h
+cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h ../../include/myHashMap.h cirAig.h \
+ cirStrash.h cirRewrite.h ../../include/sat.h ../../include/Solver.h \
  ../../include/SolverTypes.h ../../include/Global.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
- ../../include/File.h ../../include/util.h ../../include/rnGen.h \
- ../../include/myUsage.h
+ ../../include/File.h cirGate.h cirCmd.h ../../include/cmdParser.h \
+ ../../include/cmdCharDef.h cirPattern.h ../../include/util.h \
+ ../../include/rnGen.h ../../include/myUsage.h
 cirFraig.o: cirFraig.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
- cirGate.h ../../include/sat.h ../../include/Solver.h \
+ cirAig.h cirStrash.h cirRewrite.h ../../include/sat.h \
+ ../../include/Solver.h ../../include/SolverTypes.h \
+ ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
+ ../../include/Proof.h ../../include/File.h cirGate.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirGate.o: cirGate.cpp cirGate.h cirDef.h ../../include/myHashMap.h \
+ ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
+ ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
+ ../../include/Proof.h ../../include/File.h cirMgr.h cirAig.h cirStrash.h \
+ cirRewrite.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h ../../include/myHashMap.h cirAig.h \
+ cirStrash.h cirRewrite.h ../../include/sat.h ../../include/Solver.h \
  ../../include/SolverTypes.h ../../include/Global.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
- ../../include/File.h ../../include/util.h ../../include/rnGen.h \
- ../../include/myUsage.h
-cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
- cirGate.h ../../include/sat.h ../../include/Solver.h \
+ ../../include/File.h cirGate.h ../../include/util.h \
+ ../../include/rnGen.h ../../include/myUsage.h
+cirOpt.o: cirOpt.cpp cirMgr.h cirDef.h ../../include/myHashMap.h cirAig.h \
+ cirStrash.h cirRewrite.h ../../include/sat.h ../../include/Solver.h \
  ../../include/SolverTypes.h ../../include/Global.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
- ../../include/File.h cirCmd.h ../../include/cmdParser.h \
- ../../include/cmdCharDef.h ../../include/util.h ../../include/rnGen.h \
- ../../include/myUsage.h
-cirOpt.o: cirOpt.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
- cirGate.h ../../include/sat.h ../../include/Solver.h \
+ ../../include/File.h cirGate.h ../../include/util.h \
+ ../../include/rnGen.h ../../include/myUsage.h
+cirPattern.o: cirPattern.cpp cirPattern.h
+cirRewrite.o: cirRewrite.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
+ cirAig.h cirStrash.h cirRewrite.h ../../include/sat.h \
+ ../../include/Solver.h ../../include/SolverTypes.h \
+ ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
+ ../../include/Proof.h ../../include/File.h cirGate.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirSim.o: cirSim.cpp cirMgr.h cirDef.h ../../include/myHashMap.h cirAig.h \
+ cirStrash.h cirRewrite.h ../../include/sat.h ../../include/Solver.h \
  ../../include/SolverTypes.h ../../include/Global.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
- ../../include/File.h ../../include/util.h ../../include/rnGen.h \
- ../../include/myUsage.h
+ ../../include/File.h cirGate.h cirPattern.h ../../include/util.h \
+ ../../include/rnGen.h ../../include/myUsage.h
@@ -0,0 +1,81 @@
+/****************************************************************************
+  FileName     [ cirAig.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the compact array-based AIG view of the netlist ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include "cirAig.h"
+#include "cirGate.h"
+
+using namespace std;
+
+/**************************************/
+/*   class CirAig member functions    */
+/**************************************/
+// "dfsList" must be in topological order (fanins before fanouts)
+void
+CirAig::build(const GateList& gateMap, const GateList& dfsList)
+{
+   unsigned n = gateMap.size();
+   _type.assign(n, UNDEF_GATE);
+   _fanin0.assign(n, 0);
+   _fanin1.assign(n, 0);
+   _level.assign(n, 0);
+   _maxLevel = 0;
+   _aigList.clear();
+   _poList.clear();
+   _piList.clear();
+   if(n != 0) _type[0] = CONST_GATE;
+
+   for(unsigned i = 0; i < dfsList.size(); i++) {
+      const CirGate* g = dfsList[i];
+      unsigned id = g->getID();
+      GateType type = g->getType();
+      _type[id] = type;
+      if(type == AIG_GATE) {
+         _fanin0[id] = g->getFaninLit(1);
+         _fanin1[id] = g->getFaninLit(2);
+         unsigned l0 = _level[var(_fanin0[id])], l1 = _level[var(_fanin1[id])];
+         _level[id] = 1 + (l0 > l1 ? l0 : l1);
+         if(_level[id] > _maxLevel) _maxLevel = _level[id];
+         _aigList.push_back(id);
+      }
+      else if(type == PO_GATE) {
+         _fanin0[id] = g->getFaninLit();
+         _level[id] = _level[var(_fanin0[id])];
+         _poList.push_back(id);
+      }
+      else if(type == PI_GATE)
+         _piList.push_back(id);
+   }
+
+   // counting sort of the AIGs by level
+   _levelStart.assign(_maxLevel + 2, 0);
+   for(unsigned i = 0; i < _aigList.size(); i++)
+      _levelStart[_level[_aigList[i]] + 1]++;
+   for(unsigned l = 1; l < _levelStart.size(); l++)
+      _levelStart[l] += _levelStart[l - 1];
+   _levelList.resize(_aigList.size());
+   IdList pos(_levelStart.begin(), _levelStart.end() - 1);
+   for(unsigned i = 0; i < _aigList.size(); i++)
+      _levelList[pos[_level[_aigList[i]]]++] = _aigList[i];
+}
+
+void
+CirAig::addAig(unsigned id, unsigned fanin0, unsigned fanin1)
+{
+   if(id >= size()) {
+      _type.resize(id + 1, UNDEF_GATE);
+      _fanin0.resize(id + 1, 0);
+      _fanin1.resize(id + 1, 0);
+      _level.resize(id + 1, 0);
+   }
+   _type[id] = AIG_GATE;
+   _fanin0[id] = fanin0;
+   _fanin1[id] = fanin1;
+   unsigned l0 = _level[var(fanin0)], l1 = _level[var(fanin1)];
+   _level[id] = 1 + (l0 > l1 ? l0 : l1);
+}
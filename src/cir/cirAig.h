@@ -0,0 +1,71 @@
+/****************************************************************************
+  FileName     [ cirAig.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the compact array-based AIG view of the netlist ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_AIG_H
+#define CIR_AIG_H
+
+#include <vector>
+#include "cirDef.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Read-only struct-of-arrays cache of the gates reachable from the POs.
+// Every array is indexed by gate ID and fanins are stored as literals
+// (2 * ID + inv), so the hot loops of simulation, strash and SAT loading
+// never have to chase CirGate pointers. The CirGate objects stay the
+// netlist itself; this is an extra copy on top of them (it adds memory,
+// it does not save any), rebuilt by CirMgr::DFS() whenever the netlist
+// changes. IDs without a definition (UNDEF) read as constant 0.
+class CirAig
+{
+public:
+   CirAig() {}
+   ~CirAig() {}
+
+   void build(const GateList& gateMap, const GateList& dfsList);
+   // AIG created after build(); the lists only get it at the next build()
+   void addAig(unsigned id, unsigned fanin0, unsigned fanin1);
+
+   unsigned size() const { return _type.size(); }
+   GateType type(unsigned id) const { return GateType(_type[id]); }
+   // AIG: both fanins; PO: fanin0 only
+   unsigned fanin0(unsigned id) const { return _fanin0[id]; }
+   unsigned fanin1(unsigned id) const { return _fanin1[id]; }
+   unsigned level(unsigned id) const { return _level[id]; }
+   unsigned maxLevel() const { return _maxLevel; }
+
+   // AIGs in topological order, and POs / PIs in DFS order
+   const IdList& aigList() const { return _aigList; }
+   const IdList& poList() const { return _poList; }
+   const IdList& piList() const { return _piList; }
+   // AIGs bucketed by level; the AIGs of level l are
+   // levelList()[levelBegin(l) .. levelBegin(l + 1)), in topological order
+   const IdList& levelList() const { return _levelList; }
+   unsigned levelBegin(unsigned l) const { return _levelStart[l]; }
+
+   static unsigned var(unsigned lit) { return lit >> 1; }
+   static bool     isInv(unsigned lit) { return lit & 1; }
+
+private:
+   vector<unsigned char>   _type;
+   vector<unsigned>        _fanin0;
+   vector<unsigned>        _fanin1;
+   vector<unsigned>        _level;
+   unsigned                _maxLevel;
+
+   IdList                  _aigList;
+   IdList                  _poList;
+   IdList                  _piList;
+   IdList                  _levelList;
+   IdList                  _levelStart;
+};
+
+#endif // CIR_AIG_H
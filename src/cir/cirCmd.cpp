@@ -12,12 +12,16 @@
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "cirCmd.h"
+#include "cirPattern.h"
 #include "util.h"
 
 using namespace std;
 
 extern CirMgr* cirMgr;
-extern int effLimit;
+
+// upper bound of -Threads; also keeps the default -Width of CIRSIMulate
+// (512 patterns per thread) within an int
+#define CIR_MAX_THREADS 256
 
 bool
 initCirCmd()
@@ -27,11 +31,13 @@ initCirCmd()
          cmdMgr->regCmd("CIRGate", 4, new CirGateCmd) &&
          cmdMgr->regCmd("CIRSWeep", 5, new CirSweepCmd) &&
          cmdMgr->regCmd("CIROPTimize", 6, new CirOptCmd) &&
+         cmdMgr->regCmd("CIRREWrite", 6, new CirRewriteCmd) &&
          cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
          cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
          cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd) &&
          cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd) &&
-         cmdMgr->regCmd("CIREffort", 4, new CirEffortCmd)
+         cmdMgr->regCmd("CIREffort", 4, new CirEffortCmd) &&
+         cmdMgr->regCmd("CIRConvert", 4, new CirConvertCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
       return false;
@@ -328,6 +334,49 @@ CirOptCmd::help() const
         << "perform trivial optimizations\n";
 }
 
+//----------------------------------------------------------------------
+//    CIRREWrite
+//----------------------------------------------------------------------
+CmdExecStatus
+CirRewriteCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   if (!options.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+
+   assert(curCmd != CIRINIT);
+   if (curCmd == CIRSIMULATE) {
+      cerr << "Error: circuit has been simulated!! Do \"CIRFraig\" first!!"
+           << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cirMgr->rewrite();
+   // the netlist is left strashed
+   curCmd = CIRSTRASH;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirRewriteCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRREWrite" << endl;
+}
+
+void
+CirRewriteCmd::help() const
+{
+   cout << setw(15) << left << "CIRREWrite: "
+        << "rewrite 4-input cuts into smaller AIG structures\n";
+}
+
 //----------------------------------------------------------------------
 //    CIRSTRash
 //----------------------------------------------------------------------
@@ -376,7 +425,8 @@ CirStrashCmd::help() const
 
 //----------------------------------------------------------------------
 //    CIRSIMulate <-Random | -File <string patternFile>>
-//                [-Output (string logFile)]
+//                [-Width (int patterns)] [-Threads (int num)]
+//                [-Output (string logFile) [-Binary]]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirSimCmd::exec(const string& option)
@@ -389,9 +439,11 @@ CirSimCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   ifstream patternFile;
+   string patternFile, logName;
    ofstream logFile;
-   bool doRandom = false, doFile = false, doLog = false;
+   bool doRandom = false, doFile = false, doLog = false, doWidth = false;
+   bool doThreads = false, doBinary = false;
+   int width = 64, threads = 1;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Random", options[i], 2) == 0) {
          if (doRandom || doFile)
@@ -403,37 +455,75 @@ CirSimCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         patternFile.open(options[i].c_str(), ios::in);
-         if (!patternFile)
+         if (!ifstream(options[i].c_str()))
             return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         patternFile = options[i];
          doFile = true;
       }
+      else if (myStrNCmp("-Width", options[i], 2) == 0) {
+         if (doWidth)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         // patterns per pass; must be a positive multiple of 64
+         if (!myStr2Int(options[i], width) || width <= 0 || width % 64 != 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doWidth = true;
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (doThreads)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threads) || threads <= 0 ||
+             threads > CIR_MAX_THREADS)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThreads = true;
+      }
       else if (myStrNCmp("-Output", options[i], 2) == 0) {
          if (doLog)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         logFile.open(options[i].c_str(), ios::out);
-         if (!logFile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         logName = options[i];
          doLog = true;
       }
+      else if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (doBinary)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBinary = true;
+      }
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
    if (!doRandom && !doFile)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (doBinary && !doLog)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Binary");
+   if (doLog) {
+      logFile.open(logName.c_str(), doBinary ? ios::out | ios::binary : ios::out);
+      if (!logFile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, logName);
+   }
+   // by default give every worker one cache line of words (512 patterns)
+   // per pass
+   if (doThreads && !doWidth)
+      width = 512 * threads;
 
    assert (curCmd != CIRINIT);
    if (doLog)
-      cirMgr->setSimLog(&logFile);
+      cirMgr->setSimLog(&logFile, doBinary);
    else cirMgr->setSimLog(0);
 
+   cirMgr->setSimWidth(width / 64);
+   cirMgr->setSimThreads(threads);
    if (doRandom)
       cirMgr->randomSim();
    else
       cirMgr->fileSim(patternFile);
+   cirMgr->setSimWidth(1);
+   cirMgr->setSimThreads(1);
    cirMgr->setSimLog(0);
    curCmd = CIRSIMULATE;
    
@@ -444,7 +534,8 @@ void
 CirSimCmd::usage(ostream& os) const
 {
    os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>\n"
-      << "                   [-Output (string logFile)]" << endl;
+      << "                   [-Width (int patterns)] [-Threads (int num)]\n"
+      << "                   [-Output (string logFile) [-Binary]]" << endl;
 }
 
 void
@@ -455,7 +546,7 @@ CirSimCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRFraig
+//    CIRFraig [-Threads (int num)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirFraigCmd::exec(const string& option)
@@ -468,14 +559,33 @@ CirFraigCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   if (!options.empty())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+   bool doThreads = false, piDecision = false;
+   int threads = 1;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-PIDecision", options[i], 4) == 0) {
+         if (piDecision)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         piDecision = true;
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (doThreads)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threads) || threads <= 0 ||
+             threads > CIR_MAX_THREADS)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThreads = true;
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+   }
 
    if (curCmd != CIRSIMULATE) {
       cerr << "Error: circuit is not yet simulated!!" << endl;
       return CMD_EXEC_ERROR;
    }
-   cirMgr->fraig();
+   cirMgr->fraig(threads, piDecision);
    curCmd = CIRFRAIG;
 
    return CMD_EXEC_DONE;
@@ -484,7 +594,7 @@ CirFraigCmd::exec(const string& option)
 void
 CirFraigCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRFraig" << endl;
+   os << "Usage: CIRFraig [-Threads (int num)] [-PIDecision]" << endl;
 }
 
 void
@@ -495,7 +605,7 @@ CirFraigCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRWrite [(int gateId)][-Output (string aagFile)]
+//    CIRWrite [(int gateId)][-Output (string aagFile) [-Binary]]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirWriteCmd::exec(const string& option)
@@ -512,9 +622,10 @@ CirWriteCmd::exec(const string& option)
       cirMgr->writeAag(cout);
       return CMD_EXEC_DONE;
    }
-   bool hasFile = false;
+   bool hasFile = false, binary = false;
    int gateId;
    CirGate *thisGate = NULL;
+   string fileName;
    ofstream outfile;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Output", options[i], 2) == 0) {
@@ -522,11 +633,14 @@ CirWriteCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         outfile.open(options[i].c_str(), ios::out);
-         if (!outfile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[1]);
+         fileName = options[i];
          hasFile = true;
       }
+      else if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (binary)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         binary = true;
+      }
       else if (myStr2Int(options[i], gateId) && gateId >= 0) {
          if (thisGate != NULL)
             return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
@@ -543,9 +657,22 @@ CirWriteCmd::exec(const string& option)
       else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
+   // binary AIGER is only written for the whole netlist into a file
+   if (binary && (!hasFile || thisGate))
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Binary");
+   if (!hasFile && !thisGate) {
+      cirMgr->writeAag(cout);
+      return CMD_EXEC_DONE;
+   }
+   if (hasFile) {
+      outfile.open(fileName.c_str(), binary ? ios::out | ios::binary : ios::out);
+      if (!outfile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
+   }
+
    if (!thisGate) {
-      assert (hasFile);
-      cirMgr->writeAag(outfile);
+      if (binary) cirMgr->writeAig(outfile);
+      else cirMgr->writeAag(outfile);
    }
    else if (hasFile) cirMgr->writeGate(outfile, thisGate);
    else cirMgr->writeGate(cout, thisGate);
@@ -556,14 +683,15 @@ CirWriteCmd::exec(const string& option)
 void
 CirWriteCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRWrite [(int gateId)][-Output (string aagFile)]" << endl;
+   os << "Usage: CIRWrite [(int gateId)][-Output (string aagFile) [-Binary]]"
+      << endl;
 }
 
 void
 CirWriteCmd::help() const
 {
    cout << setw(15) << left << "CIRWrite: "
-        << "write the netlist to an ASCII AIG file (.aag)\n";
+        << "write the netlist to an AIG file (.aag or .aig)\n";
 }
 
 //----------------------------------------------------------------------
@@ -607,3 +735,34 @@ CirEffortCmd::help() const
 {  
    cout << setw(15) << left << "CIREffort: " << "change prooving effort\n";
 }
+
+//----------------------------------------------------------------------
+//    CIRConvert <string inPatternFile> <string outPatternFile>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirConvertCmd::exec(const string& option)
+{
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options, 2))
+      return CMD_EXEC_ERROR;
+
+   if (!convertPatternFile(options[0], options[1]))
+      return CMD_EXEC_ERROR;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirConvertCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRConvert <string inPatternFile> <string outPatternFile>"
+      << endl;
+}
+
+void
+CirConvertCmd::help() const
+{
+   cout << setw(15) << left << "CIRConvert: "
+        << "convert a pattern file between text and binary\n";
+}
@@ -16,10 +16,12 @@ CmdClass(CirPrintCmd);
 CmdClass(CirGateCmd);
 CmdClass(CirSweepCmd);
 CmdClass(CirOptCmd);
+CmdClass(CirRewriteCmd);
 CmdClass(CirStrashCmd);
 CmdClass(CirSimCmd);
 CmdClass(CirFraigCmd);
 CmdClass(CirWriteCmd);
 CmdClass(CirEffortCmd);
+CmdClass(CirConvertCmd);
 
 #endif // CIR_CMD_H
@@ -21,6 +21,7 @@ using namespace std;
 class CirGate;
 class CirMgr;
 class SatSolver;
+class SATModel;
 
 typedef vector<CirGate*>           GateList;
 typedef vector<unsigned>           IdList;
@@ -7,12 +7,14 @@
 ****************************************************************************/
 
 #include <cassert>
+#include <climits>
 #include <queue>
+#include <thread>
 #include <utility>
 #include "cirMgr.h"
 #include "cirGate.h"
+#include "cirStrash.h"
 #include "sat.h"
-#include "myHashMap.h"
 #include "util.h"
 
 using namespace std;
@@ -27,53 +29,162 @@ using namespace std;
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+// candidate pairs proved per round of the parallel fraig, per thread
+#define FRAIG_PAIRS_PER_THREAD 64
+// counterexamples the serial fraig collects before simulating them
+#define FRAIG_CEX_BATCH        16
+// conflicts allowed to the first proof of a pair; undecided pairs are
+// retried up to FRAIG_RETRY_ROUNDS times, with the budget multiplied by
+// FRAIG_BUDGET_GROWTH every round
+#define FRAIG_CONFLICT_BUDGET  1000
+#define FRAIG_BUDGET_GROWTH    8
+#define FRAIG_RETRY_ROUNDS     3
+// pairs whose joint support has at most FRAIG_TABLE_MAX_PIS PIs are decided
+// by truth tables, if those of the joint cone fit in FRAIG_TABLE_MAX_WORDS
+// words (32 MB per SATModel)
+#define FRAIG_TABLE_MAX_PIS    16
+#define FRAIG_TABLE_MAX_WORDS  (1 << 22)
+
+// Worker of a fraig batch: proves batch[begin], batch[begin + step],...
+// and records the results, with the counterexample words
+// (cex[k * #PIs + j]) of the SAT ones
+static void
+proveBatch(SATModel* model, const GateList& PIs,
+           const vector<pair<size_t, size_t>>& batch, unsigned begin,
+           unsigned step, int64 budget, vector<char>& res, vector<size_t>& cex)
+{
+   for(unsigned k = begin; k < batch.size(); k += step) {
+      res[k] = model->prove(batch[k].second, batch[k].first, budget);
+      if(res[k] == SAT_RES)
+         model->getCexWords(batch[k].second, batch[k].first, PIs,
+                            &cex[k * PIs.size()]);
+   }
+}
 
 /*******************************************/
 /*   Public member functions about fraig   */
 /*******************************************/
 // _floatList may be changed.
 // _unusedList and _undefList won't be changed
+// Leaves _strashTable holding every AIG in the DFS list, keyed on its
+// (merged) fanins; replaceGate() keeps it that way from then on
 void
 CirMgr::strash()
 {
-   HashMap<TwoFanins, CirGate*> hashMap(_dfsList.size());
-   for(unsigned i = 0; i < _dfsList.size(); i++) {
-      if(_dfsList[i]->getTypeStr() != "AIG") continue;
-      TwoFanins fanins = _dfsList[i]->getFanins();
-      CirGate* mergeGate;
-      if(hashMap.query(fanins, mergeGate)) {
+   // literal each gate has been merged into (itself if not merged)
+   IdList repr(_aig.size());
+   for(unsigned i = 0; i < repr.size(); i++) repr[i] = 2 * i;
+
+   const IdList& aigs = _aig.aigList();
+   _strashTable.init(aigs.size());
+   for(unsigned i = 0; i < aigs.size(); i++) {
+      unsigned a = _aig.fanin0(aigs[i]);
+      unsigned b = _aig.fanin1(aigs[i]);
+      unsigned mergeId = _strashTable.insert(
+         repr[CirAig::var(a)] ^ CirAig::isInv(a),
+         repr[CirAig::var(b)] ^ CirAig::isInv(b), aigs[i]);
+      if(mergeId != aigs[i]) {
          // merge
-         _dfsList[i]->mergeSTR(mergeGate);
-         gateMap[_dfsList[i]->getID()] = 0;
+         gateMap[aigs[i]]->mergeSTR(gateMap[mergeId]);
+         gateMap[aigs[i]] = 0;
+         repr[aigs[i]] = 2 * mergeId;
       }
-      else
-         hashMap.insert(fanins, _dfsList[i]);
    }
+   _strashed = true;
    updateGateLists();
    sortAllFanouts();
    DFS();
 }
 
+// Replaces "gate" by the tagged gate "by" in all its fanouts and removes it
+// from gateMap and its FEC group. Once the netlist is strashed, every AIG
+// fanout is rehashed on its new fanins, and one that now matches another
+// node is merged with that node in turn, so merges cascade to the fanouts
+// and no structural duplicate is left for the next strash().
+// "by" must not be above "gate" in level (of the last DFS()); the cascade
+// keeps the lower node of a pair as well, so every fanin edge still goes
+// up in level and no merge can close a cycle
+void
+CirMgr::replaceGate(CirGate* gate, size_t by)
+{
+   vector<pair<CirGate*, size_t>> work(1, make_pair(gate, by));
+   gateMap[gate->getID()] = 0;
+   _mergedInto[gate->getID()] = by;
+   if(simulated) deleteFromFECGrp(gate);
+
+   for(unsigned k = 0; k < work.size(); k++) {
+      CirGate* g = work[k].first;
+      // the replacement may have been merged itself in the meantime
+      size_t r = liveGate(work[k].second);
+      CirGate* rG = CirGate::unmask(r);
+      bool inv = CirGate::isInverting(r);
+      if(k > 0)
+         cout << "Strashing: " << rG->getID() << " merging "
+              << (inv ? "!" : "") << g->getID() << "..." << endl;
+      unhash(g);
+      g->rmRelatingFanouts();
+      const vector<size_t>& fanouts = g->getFanouts();
+      for(unsigned i = 0; i < fanouts.size(); i++) {
+         CirGate* f = CirGate::unmask(fanouts[i]);
+         bool live = gateMap[f->getID()] != 0;
+         if(live) unhash(f);
+         f->newFanin(g, rG, inv);
+         rG->setFanout(f, CirGate::isInverting(fanouts[i]) != inv);
+         // gates outside the DFS list have no level and are left alone
+         if(!live || !_strashed || _aig.type(f->getID()) != AIG_GATE)
+            continue;
+         unsigned a = f->getFaninLit(1), b = f->getFaninLit(2);
+         unsigned id = _strashTable.insert(a, b, f->getID());
+         if(id == f->getID()) continue;
+         CirGate* e = gateMap[id];
+         if(_aig.level(id) > _aig.level(f->getID())) {
+            _strashTable.erase(a, b, id);
+            _strashTable.insert(a, b, f->getID());
+            swap(e, f);
+         }
+         work.push_back(make_pair(f, size_t(e)));
+         gateMap[f->getID()] = 0;
+         _mergedInto[f->getID()] = size_t(e);
+         if(simulated) deleteFromFECGrp(f);
+      }
+   }
+}
+
 void
-CirMgr::fraig()
+CirMgr::fraig(unsigned nThreads, bool piDecision)
 {
    if(!simulated) return;
 
-   // initialize SATModel
-   SATModel satModel(gateMap.size());
-   satModel.setGate(constGate);
-   for(unsigned i = 0; i < _dfsList.size(); i++) {
-      if(_dfsList[i]->getTypeStr() != "PO")
-         satModel.setGate(_dfsList[i]);
-   }
+   if(nThreads > 1) fraigParallel(nThreads, piDecision);
+   else fraigSerial(piDecision);
 
-   // collect SAT patterns
-   vector<SimValue> patterns;
-   patterns.resize(PIs.size());
-   unsigned patternNumber = 0;
+   simulated = false;
+
+   updateGateLists();
+   sortAllFanouts();
+   DFS();
+
+   // the merges were strashed on the fly once the netlist was
+   if(!_strashed) strash();
+}
 
-   // the list of pairs of gates to merge
-   vector<pair<size_t, size_t>> mergeList;
+/********************************************/
+/*   Private member functions about fraig   */
+/********************************************/
+void
+CirMgr::fraigSerial(bool piDecision)
+{
+   // cones are loaded into the SATModel on demand by prove()
+   prepareSATModels(1, piDecision);
+   SATModel& satModel = *_satModels[0];
+
+   // distance-1 patterns of the counterexamples not simulated yet, and the
+   // (target, gate) ID pairs they tell apart
+   vector<size_t> cex;
+   vector<pair<unsigned, unsigned>> satPairs;
+
+   // pairs that ran out of conflict budget
+   vector<pair<size_t, size_t>> deferred;
    
    // to iterate a single FEC group
    unsigned checkTimes = 0;
@@ -83,13 +194,17 @@ CirMgr::fraig()
    checkMap.resize(gateMap.size(), false);
    checkMap[0] = true;
 
-   // check by order of _dfsList
-   // if UNSAT => push merge list, target merging thisGate
-   // if SAT => push patterns
-   for(unsigned i = 0; i < _dfsList.size(); i++) {
-      if(_dfsList[i]->getTypeStr() != "AIG") continue;
-
-      size_t fecGrp_size_t = cirMgr->getFECGrp(_dfsList[i]->getID());
+   // check AIGs level by level (a topological order)
+   // if UNSAT => merge thisGate into target right away
+   // if SAT => keep the counterexample and try the next target of thisGate;
+   //           every FRAIG_CEX_BATCH of them are simulated together, and
+   //           thisGate is then revisited in its refined FEC group
+   // if UNDECIDED => defer the pair and go on with the next gate
+   const IdList& aigs = _aig.levelList();
+   for(unsigned i = 0; i < aigs.size(); i++) {
+      // merged by an earlier pair or by the strash cascade
+      if(gateMap[aigs[i]] == 0) { checkTimes = 0; continue; }
+      size_t fecGrp_size_t = cirMgr->getFECGrp(aigs[i]);
       if(fecGrp_size_t == 0) continue;
 
       FECGroup* fecGrp = (FECGroup*)(fecGrp_size_t / 2 * 2);
@@ -97,14 +212,16 @@ CirMgr::fraig()
 
       bool inv = (CirGate::isInverting(fecGrp_size_t) != 
                CirGate::isInverting((*fecGrp)[0]));
-      size_t thisGate = size_t(_dfsList[i]) ^ (inv ? 0x1 : 0);
+      size_t thisGate = size_t(gateMap[aigs[i]]) ^ (inv ? 0x1 : 0);
       size_t target = (*fecGrp)[checkTimes];
 
       if(thisGate == target) { 
          checkMap[CirGate::unmask(thisGate)->getID()] = true;
          checkTimes++; i--; continue; 
       }
-      if(target == 0) { checkTimes++; i--; continue; }
+      if(target == 0 || liveGate(target) != target) {
+         checkTimes++; i--; continue;
+      }
       if(checkMap[CirGate::unmask(target)->getID()] == false) {
          checkTimes++; i--; continue;
       }
@@ -119,109 +236,218 @@ CirMgr::fraig()
       cout << CirGate::unmask(thisGate)->getID() << ")...";
       cout.flush();
       
-      if(satModel.prove(thisGate, target)) {
-         cout << "SAT!!";
+      SatResult result = satModel.prove(thisGate, target,
+                                        FRAIG_CONFLICT_BUDGET);
+      if(result == UNDECIDED_RES) {
+         cout << "UNDECIDED!!";
          cout.flush();
 
-         for(unsigned j = 0; j < PIs.size(); j++) {
-            int satVal = satModel.getValue(PIs[j]->getID());
-            assert(satVal != -1);
-            patterns[j] <<=1;
-            if(satVal == 1)
-               patterns[j] += 1;
-         }
-         patternNumber++;
-
-         if(_effort == LOW_EFF || _effort == MEDIUM_EFF) {
-            checkTimes++; i--; 
-         }
-         if(_effort == HIGH_EFF) {
-            if(checkTimes >= 4 && checkTimes >= fecGrp->size() / 4) { checkTimes++; i--; }
-            else { deleteFromFECGrp(CirGate::unmask(thisGate)); checkTimes = 0; }
-         }
-         if(_effort == SUPER_EFF) {
-            if(checkTimes >= 2) { checkTimes++; i--; }
-            else { deleteFromFECGrp(CirGate::unmask(thisGate)); checkTimes = 0; }
-         }
+         deferred.push_back(make_pair(target, thisGate));
+         checkTimes = 0;
       }
-      else {
-         cout << "UNSAT!!";
+      else if(result == SAT_RES) {
+         cout << "SAT!! ";
          cout.flush();
 
-         mergeList.push_back(make_pair(target, thisGate));
-         deleteFromFECGrp(CirGate::unmask(thisGate));
-         checkTimes = 0;
-      }
-      
-      if(patternNumber == sizeof(size_t) * 8 - 1) {
-         cout << "\rUpdating by SAT... ";
-         simulateAll(patterns);
-         identifyFECs();
-         sortFECGrps();
-         cout << endl;
-         patternNumber = 0;
+         cex.resize(cex.size() + PIs.size());
+         satModel.getCexWords(thisGate, target, PIs,
+                              &cex[cex.size() - PIs.size()]);
+         satPairs.push_back(make_pair(CirGate::unmask(target)->getID(),
+                                      aigs[i]));
+         checkTimes++; i--;
+         if(satPairs.size() < FRAIG_CEX_BATCH) continue;
+
+         cout << "\r                                   \r";
+         simulateCex(cex);
+         separateSatPairs(satPairs);
+         cex.clear();
+         satPairs.clear();
          checkTimes = 0;
       }
-      else if(mergeList.size() > 400) {
+      else {
+         cout << "UNSAT!!";
          cout << "\r                                   \r";
-         for(unsigned j = 0; j < mergeList.size(); j++) {
-            CirGate* thisG = CirGate::unmask(mergeList[j].second);
-            CirGate* trgtG = CirGate::unmask(mergeList[j].first);
-            bool inv =  CirGate::isInverting(mergeList[j].second) ^
-               CirGate::isInverting(mergeList[j].first);
-            thisG->mergeFRAIG(trgtG, inv);
-            gateMap[thisG->getID()] = 0;
-         }
-         cout << "Updating by UNSAT... ";
-         identifyFECs();
-         sortFECGrps();
-         mergeList.clear();
-         cout << endl;
-
-         cout << "Updating by SAT... ";
-         simulateAll(patterns);
-         identifyFECs();
-         sortFECGrps();
-         cout << endl;
-         patternNumber = 0;
+         mergeEquivalent(target, thisGate);
          checkTimes = 0;
       }
    }
 
+   if(!satPairs.empty()) {
+      cout << "\r                                   \r";
+      simulateCex(cex);
+      separateSatPairs(satPairs);
+   }
    cout << "\r                                   \r";
-   for(unsigned j = 0; j < mergeList.size(); j++) {
-      CirGate* thisG = CirGate::unmask(mergeList[j].second);
-      CirGate* trgtG = CirGate::unmask(mergeList[j].first);
-      bool inv =  CirGate::isInverting(mergeList[j].second) ^
-         CirGate::isInverting(mergeList[j].first);
-      thisG->mergeFRAIG(trgtG, inv);
-      gateMap[thisG->getID()] = 0;
+   if(!deferred.empty())
+      retryFraigPairs(vector<SATModel*>(1, &satModel), deferred);
+   sortFECGrps();
+   cout << "Updating by UNSAT... Total #FEC Group = " << fecGrps.size() << endl;
+}
+
+// Proves in rounds: every FEC member is paired with the member of its group
+// that comes first in level order (so a merge never creates a cycle), and
+// pair k of a round goes to the SATModel of thread k % nThreads. UNSAT pairs
+// are merged and counterexamples simulated in pair order, so a run is
+// reproducible for a given nThreads
+void
+CirMgr::fraigParallel(unsigned nThreads, bool piDecision)
+{
+   prepareSATModels(nThreads, piDecision);
+   vector<SATModel*> models(_satModels.begin(), _satModels.begin() + nThreads);
+
+   const IdList& aigs = _aig.levelList();
+   IdList order(gateMap.size(), UINT_MAX);
+   order[0] = 0;
+   for(unsigned i = 0; i < aigs.size(); i++)
+      order[aigs[i]] = i + 1;
+
+   // the representative each gate was last proved against
+   vector<size_t> tried(gateMap.size(), 0);
+   vector<pair<size_t, size_t>> batch, deferred;
+   vector<size_t> reprs;
+
+   while(true) {
+      reprs.assign(fecGrps.size(), 0);
+      for(unsigned i = 0; i < fecGrps.size(); i++) {
+         if(fecGrps[i] == 0) continue;
+         const FECGroup& grp = *fecGrps[i];
+         for(unsigned j = 0; j < grp.size(); j++) {
+            if(grp[j] == 0) continue;
+            if(reprs[i] == 0 || order[CirGate::unmask(grp[j])->getID()] <
+                                order[CirGate::unmask(reprs[i])->getID()])
+               reprs[i] = grp[j];
+         }
+      }
+
+      batch.clear();
+      for(unsigned i = 0; i < aigs.size(); i++) {
+         if(batch.size() == FRAIG_PAIRS_PER_THREAD * nThreads) break;
+         if(gateMap[aigs[i]] == 0 || fecGrpMap[aigs[i]] == 0) continue;
+         size_t fecGrp_size_t = getFECGrp(aigs[i]);
+         FECGroup* fecGrp = (FECGroup*)(fecGrp_size_t / 2 * 2);
+         size_t target = reprs[fecGrpMap[aigs[i]] - 1];
+         if(CirGate::unmask(target) == gateMap[aigs[i]]) continue;
+         if(tried[aigs[i]] == target) continue;
+         tried[aigs[i]] = target;
+         bool inv = (CirGate::isInverting(fecGrp_size_t) !=
+                     CirGate::isInverting((*fecGrp)[0]));
+         batch.push_back(make_pair(target,
+                         size_t(gateMap[aigs[i]]) ^ (inv ? 0x1 : 0)));
+      }
+      if(batch.empty()) break;
+
+      proveFraigBatch(models, batch, FRAIG_CONFLICT_BUDGET, deferred);
    }
-   cout << "Updating by UNSAT... ";
-   identifyFECs();
+   retryFraigPairs(models, deferred);
+
    sortFECGrps();
-   mergeList.clear();
-   cout << endl;
+   cout << "Updating by UNSAT... Total #FEC Group = " << fecGrps.size() << endl;
+}
+
+// Proves "batch" with one thread per model (pair k on models[k % #models]).
+// UNSAT pairs are merged and SAT counterexamples simulated in pair order;
+// undecided pairs are appended to "deferred"
+void
+CirMgr::proveFraigBatch(const vector<SATModel*>& models,
+                        const vector<pair<size_t, size_t>>& batch,
+                        int64 budget, vector<pair<size_t, size_t>>& deferred)
+{
+   unsigned nThreads = models.size();
+   vector<char> res(batch.size(), UNSAT_RES);
+   vector<size_t> cex(batch.size() * PIs.size(), 0);
+
+   cout << "\r                                   \r";
+   cout << "Proving " << batch.size() << " pairs...";
+   cout.flush();
+   vector<thread> workers;
+   for(unsigned t = 1; t < nThreads; t++)
+      workers.push_back(thread(proveBatch, models[t], cref(PIs), cref(batch),
+                               t, nThreads, budget, ref(res), ref(cex)));
+   proveBatch(models[0], PIs, batch, 0, nThreads, budget, res, cex);
+   for(unsigned t = 0; t < workers.size(); t++)
+      workers[t].join();
+   cout << "\r                                   \r";
+
+   unsigned nSat = 0;
+   for(unsigned k = 0; k < batch.size(); k++) {
+      if(res[k] == SAT_RES) { nSat++; continue; }
+      if(res[k] == UNDECIDED_RES) { deferred.push_back(batch[k]); continue; }
+      mergeEquivalent(batch[k].first, batch[k].second);
+   }
+   if(nSat == 0) return;
+
+   unsigned p = 0;
+   for(unsigned k = 0; k < batch.size(); k++) {
+      if(res[k] != SAT_RES) continue;
+      copy(cex.begin() + k * PIs.size(), cex.begin() + (k + 1) * PIs.size(),
+           cex.begin() + p * PIs.size());
+      p++;
+   }
+   cex.resize(p * PIs.size());
+   simulateCex(cex);
+}
 
+// "cex" holds one word of distance-1 patterns per PI for every
+// counterexample, counterexample by counterexample; they are simulated as
+// one word each and the FEC groups refined
+void
+CirMgr::simulateCex(const vector<size_t>& cex)
+{
+   unsigned nWords = cex.size() / PIs.size();
+   vector<size_t> patterns(cex.size());
+   for(unsigned k = 0; k < nWords; k++)
+      for(unsigned j = 0; j < PIs.size(); j++)
+         patterns[j * nWords + k] = cex[k * PIs.size() + j];
    cout << "Updating by SAT... ";
-   simulateAll(patterns);
+   simulateAll(patterns.data(), nWords);
    identifyFECs();
-   sortFECGrps();
    cout << endl;
+}
 
-   simulated = false;
-
-   updateGateLists();
-   sortAllFanouts();
-   DFS();
-
-   strash();
+// Checks that the simulated counterexamples split every (target, gate)
+// pair they were found for. A pair left in one group can only come from a
+// bogus counterexample; its gate is then dropped from the group so that it
+// is not proved against the same target again
+void
+CirMgr::separateSatPairs(const vector<pair<unsigned, unsigned>>& pairs)
+{
+   for(unsigned k = 0; k < pairs.size(); k++) {
+      unsigned t = pairs[k].first, g = pairs[k].second;
+      if(gateMap[t] == 0 || gateMap[g] == 0) continue;
+      bool split = fecGrpMap[g] == 0 || fecGrpMap[g] != fecGrpMap[t];
+      assert(split);
+      if(!split) deleteFromFECGrp(gateMap[g]);
+   }
+}
 
+// Retries the undecided pairs once the easy ones are merged, with a growing
+// budget; pairs merged or split in the meantime are dropped and whatever is
+// still undecided after the last round is left unmerged
+void
+CirMgr::retryFraigPairs(const vector<SATModel*>& models,
+                        vector<pair<size_t, size_t>>& deferred)
+{
+   int64 budget = FRAIG_CONFLICT_BUDGET;
+   vector<pair<size_t, size_t>> batch;
+   for(unsigned r = 0; r < FRAIG_RETRY_ROUNDS && !deferred.empty(); r++) {
+      budget *= FRAIG_BUDGET_GROWTH;
+      batch.clear();
+      for(unsigned k = 0; k < deferred.size(); k++) {
+         unsigned t = CirGate::unmask(deferred[k].first)->getID();
+         unsigned g = CirGate::unmask(deferred[k].second)->getID();
+         if(gateMap[t] == 0 || gateMap[g] == 0) continue;
+         if(fecGrpMap[g] == 0 || fecGrpMap[t] != fecGrpMap[g]) continue;
+         batch.push_back(make_pair(size_t(gateMap[t]) ^ (getFECGrp(t) & 1),
+                                   size_t(gateMap[g]) ^ (getFECGrp(g) & 1)));
+      }
+      deferred.clear();
+      if(!batch.empty())
+         proveFraigBatch(models, batch, budget, deferred);
+   }
+   if(!deferred.empty())
+      cout << "Giving up on " << deferred.size() << " undecided pairs" << endl;
 }
 
-/********************************************/
-/*   Private member functions about fraig   */
-/********************************************/
 void
 CirGate::mergeSTR(CirGate* mergeGate)
 {
@@ -243,65 +469,332 @@ CirGate::mergeFRAIG(CirGate* mergeGate, bool inv)
    if(inv) cout << '!';
    cout << getID() << "..." << endl;
 
-   rmRelatingFanouts();
-   for(unsigned i = 0; i < fanouts.size(); i++) {
-      unmask(fanouts[i])->newFanin(this, mergeGate, inv);
-      mergeGate->setFanout(unmask(fanouts[i]), isInverting(fanouts[i]) != inv);
-   }
+   cirMgr->replaceGate(this, size_t(mergeGate) ^ (inv ? 0x1 : 0));
+}
+
+// Merges a proved pair; either gate may have been merged (by an earlier
+// pair or by strashing) since, and is then replaced by the gate it went
+// into. The higher of the two is merged into the lower
+void
+CirMgr::mergeEquivalent(size_t target, size_t gate)
+{
+   target = liveGate(target);
+   gate = liveGate(gate);
+   CirGate* trgtG = CirGate::unmask(target);
+   CirGate* thisG = CirGate::unmask(gate);
+   if(trgtG == thisG) return;
+   if(_aig.level(trgtG->getID()) > _aig.level(thisG->getID()))
+      swap(trgtG, thisG);
+   thisG->mergeFRAIG(trgtG, CirGate::isInverting(target) !=
+                            CirGate::isInverting(gate));
+}
+
+// Follows the merges since the last DFS()
+size_t
+CirMgr::liveGate(size_t g) const
+{
+   while(_mergedInto[CirGate::unmask(g)->getID()] != 0)
+      g = _mergedInto[CirGate::unmask(g)->getID()] ^ CirGate::isInverting(g);
+   return g;
+}
+
+void
+CirMgr::unhash(CirGate* g)
+{
+   if(_strashed && g->isAig())
+      _strashTable.erase(g->getFaninLit(1), g->getFaninLit(2), g->getID());
 }
 
+// The last member takes the slot of the erased one, so only its position
+// changes; sortFECGrps() puts the members back in ID order. A group left
+// with one member is dissolved and its slot in fecGrps left empty (0)
+// until identifyFECs() or sortFECGrps() compacts the list
 void
 CirMgr::deleteFromFECGrp(CirGate* gate)
 {
-   if(fecGrpMap[gate->getID()] == 0) return;
-   FECGroup* fecGrp = fecGrps[fecGrpMap[gate->getID()] - 1];
-   for(unsigned i = 0; i < fecGrp->size(); i++) {
-      if(CirGate::unmask((*fecGrp)[i]) == gate)
-         (*fecGrp)[i] = 0;
-   }
+   unsigned g = fecGrpMap[gate->getID()];
+   if(g == 0) return;
    fecGrpMap[gate->getID()] = 0;
+   FECGroup* fecGrp = fecGrps[g - 1];
+   unsigned pos = fecGrpPos[gate->getID()];
+   assert(CirGate::unmask((*fecGrp)[pos]) == gate);
+   (*fecGrp)[pos] = fecGrp->back();
+   fecGrpPos[CirGate::unmask((*fecGrp)[pos])->getID()] = pos;
+   fecGrp->pop_back();
+   if(fecGrp->size() > 1) return;
+
+   fecGrpMap[CirGate::unmask((*fecGrp)[0])->getID()] = 0;
+   delete fecGrp;
+   fecGrps[g - 1] = 0;
+}
+
+// The SATModels (and the clauses they learnt) are kept across fraig()s
+void
+CirMgr::prepareSATModels(unsigned n, bool piDecision)
+{
+   for(unsigned t = 0; t < _satModels.size() && t < n; t++)
+      _satModels[t]->update(piDecision);
+   while(_satModels.size() < n)
+      _satModels.push_back(new SATModel(_aig, piDecision));
 }
 
 /********************************************/
 /*      Member functions of SATModel        */
 /********************************************/
+// Start over with a fresh solver seeded with what the last one learnt. A
+// var stands for a fixed function of the PIs, which merging equivalent
+// gates never changes, so a learnt clause stays valid as long as all its
+// gates are still in the DFS list. The old problem clauses are dropped:
+// kept, they would spread every propagation over all the cones of the
+// earlier fraig()s; the gates are loaded again as proofs reach them
 void
-SATModel::setGate(CirGate* gate)
+SATModel::update(bool piDecision)
 {
-   Var vf = solver.newVar();
-   varMap[gate->getID()] = vf;
-   if(gate->getTypeStr() == "CONST") {
-      Var vv = solver.newVar();
-      varMap[0] = vv;
-      solver.addAigCNF(vv, vf, false, vf, true);
+   vec<Lit> learnts;
+   solver.exportLearnts(learnts);
+   vector<int> gateOf(solver.nVars(), -1);
+   for(unsigned i = 0; i < varMap.size() && i < _aig.size(); i++)
+      if(varMap[i] != var_Undef && _aig.type(i) != UNDEF_GATE)
+         gateOf[varMap[i]] = i;
+
+   unsigned n = _aig.size();
+   _piDecision = piDecision;
+   _nDeadClauses = 0;
+   solver.initialize();
+   varMap.assign(n, var_Undef);
+   _loaded.assign(n, false);
+   _mark.assign(n, 0);
+   _flip.assign(n, 0);
+   _tablePos.assign(n, 0);
+   _tableValue.assign(n, 0);
+   _tableOnes.clear();
+   setGate(0);
+
+   vec<Lit> lits;
+   for(int i = 0, j; i < learnts.size(); i = j + 1) {
+      bool mapped = true;
+      for(j = i; learnts[j] != lit_Undef; j++)
+         if(gateOf[var(learnts[j])] < 0) mapped = false;
+      if(!mapped) continue;   // has a miter var or a swept gate
+      lits.clear();
+      for(int k = i; k < j; k++) {
+         unsigned g = gateOf[var(learnts[k])];
+         if(varMap[g] == var_Undef) varMap[g] = solver.newVar(false);
+         lits.push(Lit(varMap[g], sign(learnts[k])));
+      }
+      solver.importLearnt(lits);
    }
-   else if(gate->getTypeStr() == "UNDEF") {
-      Var vv = solver.newVar();
-      varMap[gate->getID()] = vv;
-      solver.addAigCNF(vv, vf, false, vf, true);
+}
+
+// Fanins must be set before the gate; UNDEF fanins share the CONST var.
+// The gate may already have a (non-decision) var from update()
+void
+SATModel::setGate(unsigned id)
+{
+   GateType type = _aig.type(id);
+   if(varMap[id] == var_Undef) varMap[id] = solver.newVar(false);
+   Var vf = varMap[id];
+   _loaded[id] = true;
+   if(type == CONST_GATE) solver.assertProperty(vf, false);
+   else if(!_piDecision || type == PI_GATE) solver.setDecisionVar(vf, true);
+   if(type != AIG_GATE) return;
+
+   unsigned a = _aig.fanin0(id);
+   unsigned b = _aig.fanin1(id);
+   Var  va = varMap[faninVar(a)];
+   Var  vb = varMap[faninVar(b)];
+
+   solver.addAigCNF(vf, va, CirAig::isInv(a), vb, CirAig::isInv(b));
+}
+
+// Tseitin-encode the part of the transitive fanin of "id" that no
+// earlier proof has loaded yet
+void
+SATModel::loadCone(unsigned id)
+{
+   if(_loaded[id]) return;
+   _stack.push_back(id);
+   while(!_stack.empty()) {
+      unsigned g = _stack.back();
+      if(_loaded[g]) { _stack.pop_back(); continue; }
+      if(_aig.type(g) == AIG_GATE) {
+         unsigned a = faninVar(_aig.fanin0(g));
+         unsigned b = faninVar(_aig.fanin1(g));
+         bool ready = true;
+         if(!_loaded[a]) { _stack.push_back(a); ready = false; }
+         if(!_loaded[b]) { _stack.push_back(b); ready = false; }
+         if(!ready) continue;
+      }
+      _stack.pop_back();
+      setGate(g);
    }
-   if(gate->getTypeStr() != "AIG") return;
+}
 
-   Var  va = varMap[gate->getFaninLit(1) / 2];
-   Var  vb = varMap[gate->getFaninLit(2) / 2];
-   bool fa = gate->getFaninLit(1) % 2;
-   bool fb = gate->getFaninLit(2) % 2;
+// Decides a == b by simulating their joint cone on all the 2^n assignments
+// of its n PIs (64 per word; PI k is bit k of the assignment index).
+// UNDECIDED_RES if n > FRAIG_TABLE_MAX_PIS or the tables are too large
+SatResult
+SATModel::proveByTable(size_t a, size_t b)
+{
+   static const size_t piWords[6] = {
+      0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+      0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+   };
+   unsigned ia = CirGate::unmask(a)->getID();
+   unsigned ib = CirGate::unmask(b)->getID();
+
+   // joint cone in topological order; stop as soon as it is too large
+   unsigned nPIs = 0;
+   bool small = true;
+   _stack.push_back(ia);
+   _stack.push_back(ib);
+   while(!_stack.empty() && small) {
+      unsigned g = _stack.back();
+      if(_mark[g]) { _stack.pop_back(); continue; }
+      if(_aig.type(g) == AIG_GATE) {
+         unsigned f0 = faninVar(_aig.fanin0(g));
+         unsigned f1 = faninVar(_aig.fanin1(g));
+         bool ready = true;
+         if(!_mark[f0]) { _stack.push_back(f0); ready = false; }
+         if(!_mark[f1]) { _stack.push_back(f1); ready = false; }
+         if(!ready) continue;
+      }
+      _stack.pop_back();
+      _mark[g] = 1;
+      _visited.push_back(g);
+      if(_aig.type(g) == PI_GATE) nPIs++;
+      small = nPIs <= FRAIG_TABLE_MAX_PIS &&
+              (size_t(_visited.size()) << (nPIs > 6 ? nPIs - 6 : 0)) <=
+              FRAIG_TABLE_MAX_WORDS;
+   }
+   _stack.clear();
+
+   SatResult result = UNDECIDED_RES;
+   if(small) {
+      unsigned nWords = nPIs > 6 ? 1 << (nPIs - 6) : 1;
+      _table.resize(_visited.size() * nWords);
+      for(unsigned i = 0, k = 0; i < _visited.size(); i++) {
+         unsigned g = _visited[i];
+         _tablePos[g] = i;
+         size_t* t = &_table[i * nWords];
+         GateType type = _aig.type(g);
+         if(type == AIG_GATE) {
+            unsigned f0 = _aig.fanin0(g), f1 = _aig.fanin1(g);
+            const size_t* t0 = &_table[_tablePos[faninVar(f0)] * nWords];
+            const size_t* t1 = &_table[_tablePos[faninVar(f1)] * nWords];
+            size_t inv0 = CirAig::isInv(f0) ? ~size_t(0) : 0;
+            size_t inv1 = CirAig::isInv(f1) ? ~size_t(0) : 0;
+            for(unsigned w = 0; w < nWords; w++)
+               t[w] = (t0[w] ^ inv0) & (t1[w] ^ inv1);
+         }
+         else if(type == PI_GATE) {
+            for(unsigned w = 0; w < nWords; w++)
+               t[w] = k < 6 ? piWords[k]
+                            : ((w >> (k - 6)) & 1 ? ~size_t(0) : 0);
+            k++;
+         }
+         else
+            for(unsigned w = 0; w < nWords; w++) t[w] = 0;
+      }
 
-   solver.addAigCNF(vf, va, fa, vb, fb);
+      const size_t* ta = &_table[_tablePos[ia] * nWords];
+      const size_t* tb = &_table[_tablePos[ib] * nWords];
+      size_t inv = CirGate::isInverting(a) != CirGate::isInverting(b) ?
+                   ~size_t(0) : 0;
+      result = UNSAT_RES;
+      for(unsigned w = 0; w < nWords; w++) {
+         size_t diff = ta[w] ^ tb[w] ^ inv;
+         if(diff == 0) continue;
+         // keep the first differing assignment as the counterexample
+         unsigned m = 64 * w + __builtin_ctzll(diff);
+         for(unsigned i = 0; i < _tableOnes.size(); i++)
+            _tableValue[_tableOnes[i]] = 0;
+         _tableOnes.clear();
+         for(unsigned i = 0, k = 0; i < _visited.size(); i++) {
+            if(_aig.type(_visited[i]) != PI_GATE) continue;
+            if((m >> k++) & 1) {
+               _tableValue[_visited[i]] = 1;
+               _tableOnes.push_back(_visited[i]);
+            }
+         }
+         result = SAT_RES;
+         break;
+      }
+   }
+   for(unsigned i = 0; i < _visited.size(); i++)
+      _mark[_visited[i]] = 0;
+   _visited.clear();
+   return result;
 }
 
-bool
-SATModel::prove(size_t a, size_t b)
+// Bit 63 of every word is the counterexample and bit 62 - k flips the k-th
+// PI (in DFS order) of the joint support of a and b, so one simulation
+// word also tries the counterexample's distance-1 neighbors
+void
+SATModel::getCexWords(size_t a, size_t b, const GateList& PIs, size_t* words)
 {
-   Var  vf = solver.newVar();
-   Var  va = varMap[CirGate::unmask(a)->getID()];
-   Var  vb = varMap[CirGate::unmask(b)->getID()];
+   unsigned nFlips = 0;
+   _stack.push_back(CirGate::unmask(a)->getID());
+   _stack.push_back(CirGate::unmask(b)->getID());
+   while(!_stack.empty()) {
+      unsigned g = _stack.back();
+      _stack.pop_back();
+      if(_mark[g]) continue;
+      _mark[g] = 1;
+      _visited.push_back(g);
+      if(_aig.type(g) == PI_GATE && nFlips < 63)
+         _flip[g] = size_t(1) << (62 - nFlips++);
+      else if(_aig.type(g) == AIG_GATE) {
+         _stack.push_back(faninVar(_aig.fanin1(g)));
+         _stack.push_back(faninVar(_aig.fanin0(g)));
+      }
+   }
+   for(unsigned j = 0; j < PIs.size(); j++) {
+      unsigned id = PIs[j]->getID();
+      words[j] = (getValue(id) == 1 ? ~size_t(0) : 0) ^ _flip[id];
+   }
+   for(unsigned i = 0; i < _visited.size(); i++) {
+      _mark[_visited[i]] = 0;
+      _flip[_visited[i]] = 0;
+   }
+   _visited.clear();
+}
+
+// Pairs with a small joint support are decided by proveByTable() and never
+// reach the solver. Otherwise the miter is retired right after the proof,
+// while the satisfying model is kept for getValue() and getCexWords().
+// Dead miter clauses are collected once there are at least 1024 of them
+// and they make up 1/8 of the clause DB
+SatResult
+SATModel::prove(size_t a, size_t b, int64 conflicts)
+{
+   _byTable = true;
+   SatResult result = proveByTable(a, b);
+   if(result != UNDECIDED_RES) return result;
+   _byTable = false;
+
+   unsigned ia = CirGate::unmask(a)->getID();
+   unsigned ib = CirGate::unmask(b)->getID();
+   loadCone(ia);
+   loadCone(ib);
+
+   Var  act = solver.newVar(false);
+   Var  va = varMap[ia];
+   Var  vb = varMap[ib];
    bool fa = CirGate::isInverting(a);
    bool fb = CirGate::isInverting(b);
 
-   solver.addXorCNF(vf, va, fa, vb, fb);
+   solver.addMiterCNF(act, va, fa, vb, fb);
    solver.assumeRelease();
-   solver.assumeProperty(vf, true);
-
-   return solver.assumpSolve();
+   solver.assumeProperty(act, true);
+   result = solver.assumpSolve(conflicts, -1);
+
+   solver.retire(act);
+   _nDeadClauses += 2;
+   if(_nDeadClauses >= 1024 &&
+      8 * _nDeadClauses >= unsigned(solver.nClauses())) {
+      solver.collectGarbage();
+      _nDeadClauses = 0;
+   }
+   return result;
 }
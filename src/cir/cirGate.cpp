@@ -56,7 +56,7 @@ CirGate::reportGate() const
       }
    cout << endl;
 
-   cout << "= Value: " << value << endl;
+   cout << "= Value: " << cirMgr->getSimValue(id) << endl;
    
    //cout.copyfmt(init);
    
@@ -116,74 +116,69 @@ CirGate::printFanout(int level, int spaces, bool mark) const
       unmask(fanouts[i])->printFanout(level - 1, spaces + 1, isInverting(fanouts[i]));
 }
 
+// Post-order DFS on an explicit stack, so deep circuits cannot overflow the
+// call stack. Fanin 1 is visited before fanin 2; UNDEF gates are skipped
+void
+CirGate::dfsTraversal(GateList& _dfsList) const
+{
+   if(isVisited()) return;
+   visit();
+
+   vector<pair<const CirGate*, unsigned>> stack;
+   stack.push_back(make_pair(this, 0));
+   while(!stack.empty()) {
+      const CirGate* g = stack.back().first;
+      unsigned next = stack.back().second;
+      if(next < g->faninSize()) {
+         stack.back().second++;
+         const CirGate* f = unmask(g->getFanin(next));
+         if(!f->isVisited()) {
+            f->visit();
+            stack.push_back(make_pair(f, 0));
+         }
+         continue;
+      }
+      stack.pop_back();
+      if(!g->isUndef()) _dfsList.push_back((CirGate*)g);
+   }
+}
+
+// Removes one entry of "torm" (a gate with both fanins from this one has
+// two, removed by one call each), in place. It is looked for from both
+// ends: gates removed in ID order are at the front of a sorted list, and
+// the fanouts added by merges are at the back
 void
 CirGate::removeFanout(const CirGate* torm)
 {
-   vector<size_t> tmp;
-   for(unsigned i = 0; i < fanouts.size(); i++) {
-      if(unmask(fanouts[i]) != torm)
-         tmp.push_back(fanouts[i]);
+   for(unsigned i = 0, j = fanouts.size(); i < j; i++) {
+      if(unmask(fanouts[i]) == torm) {
+         fanouts.erase(fanouts.begin() + i);
+         return;
+      }
+      if(unmask(fanouts[--j]) == torm) {
+         fanouts.erase(fanouts.begin() + j);
+         return;
+      }
    }
-   fanouts = tmp;
 }
 
 /********************
 ***      AIG      ***
 ********************/
 
-void
-AIGGate::dfsTraversal(GateList& _dfsList) const
-{
-   if(isVisited()) return;
-   else visit();
-
-   unmask(fanin1)->dfsTraversal(_dfsList);
-   unmask(fanin2)->dfsTraversal(_dfsList);
-
-   _dfsList.push_back((CirGate*)this);
-}
-
 void
 AIGGate::printGate() const
 {
    cout << "AIG " << getID() << " ";
-   if(unmask(fanin1)->getTypeStr() == "UNDEF") cout << "*";
+   if(unmask(fanin1)->isUndef()) cout << "*";
    if(isInverting(fanin1)) cout << "!";
    cout << unmask(fanin1)->getID() << " ";
-   if(unmask(fanin2)->getTypeStr() == "UNDEF") cout << "*";
+   if(unmask(fanin2)->isUndef()) cout << "*";
    if(isInverting(fanin2)) cout << "!";
    cout << unmask(fanin2)->getID() << endl;
    
 }
 
-void
-AIGGate::writeGate(ostream& os) const
-{
-   if(isVisited()) return;
-   else visit();
-
-   unmask(fanin1)->writeGate(os);
-   if(unmask(fanin1) != unmask(fanin2))
-      unmask(fanin2)->writeGate(os);
-
-   os << 2 * getID() << " "
-      << getFaninLit(1) << " "
-      << getFaninLit(2) << "\n";
-}
-
-void
-AIGGate::countGate(unsigned& cnt) const
-{
-   if(isVisited()) return;
-   else visit();
-
-   unmask(fanin1)->countGate(cnt);
-   if(unmask(fanin1) != unmask(fanin2))
-      unmask(fanin2)->countGate(cnt);
-
-   cnt++;
-}
-
 unsigned
 AIGGate::getFaninLit(int num) const
 {
@@ -195,8 +190,8 @@ AIGGate::getFaninLit(int num) const
 void
 AIGGate::getFloatingFanin(CirGate*& a, CirGate*& b) const
 {
-   if(unmask(fanin1)->getTypeStr() == "UNDEF") a = unmask(fanin1);
-   if(unmask(fanin2)->getTypeStr() == "UNDEF") b = unmask(fanin2);
+   if(unmask(fanin1)->isUndef()) a = unmask(fanin1);
+   if(unmask(fanin2)->isUndef()) b = unmask(fanin2);
 }
 
 bool
@@ -227,8 +222,8 @@ AIGGate::rmRelatingFanouts()
 bool
 AIGGate::haveFloatingFanin() const
 {
-   if(unmask(fanin1)->getTypeStr() == "UNDEF") return true;
-   if(unmask(fanin2)->getTypeStr() == "UNDEF") return true;
+   if(unmask(fanin1)->isUndef()) return true;
+   if(unmask(fanin2)->isUndef()) return true;
    return false;
 }
 
@@ -254,15 +249,6 @@ AIGGate::printFanin(int level, int spaces, bool mark) const
 ***       PI      ***
 ********************/
 
-void
-PIGate::dfsTraversal(GateList& _dfsList) const
-{
-   if(isVisited()) return;
-   else visit();
-
-   _dfsList.push_back((CirGate*)this);
-}
-
 void
 PIGate::printGate() const
 {
@@ -277,22 +263,11 @@ PIGate::printGate() const
 ***       PO      ***
 ********************/
 
-void
-POGate::dfsTraversal(GateList& _dfsList) const
-{
-   if(isVisited()) return;
-   else visit();
-
-   unmask(fanin)->dfsTraversal(_dfsList);
-
-   _dfsList.push_back((CirGate*)this);
-}
-
 void
 POGate::printGate() const
 {
    cout << "PO  " << getID() << " ";
-   if(unmask(fanin)->getTypeStr() == "UNDEF") cout << "*";
+   if(unmask(fanin)->isUndef()) cout << "*";
    if(isInverting(fanin)) cout << "!";
    cout << unmask(fanin)->getID();
    if(gateName.size())
@@ -338,7 +313,7 @@ POGate::setFanin(CirGate* cg, bool inv, int num)
 bool
 POGate::haveFloatingFanin() const 
 { 
-   if(unmask(fanin)->getTypeStr() == "UNDEF") return true;
+   if(unmask(fanin)->isUndef()) return true;
    return false; 
 }
 
@@ -346,15 +321,6 @@ POGate::haveFloatingFanin() const
 ***     OTHERS    ***
 ********************/
 
-void
-CONSTGate::dfsTraversal(GateList& _dfsList) const
-{
-   if(isVisited()) return;
-   else visit();
-
-   _dfsList.push_back((CirGate*)this);
-}
-
 void
 CONSTGate::printGate() const
 {
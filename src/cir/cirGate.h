@@ -33,7 +33,8 @@ public:
    virtual ~CirGate() {}
 
    // Basic access methods
-   string   getTypeStr() const { 
+   GateType getType() const { return type; }
+   const char* getTypeStr() const {
       switch(type) {
          case UNDEF_GATE: return "UNDEF";
          case PI_GATE:    return "PI";
@@ -46,17 +47,21 @@ public:
    unsigned getLineNo() const { return lineNo; }
    unsigned getID() const { return id; }
    string   getGateName() const { return gateName; }
-   SimValue getSimValue() const { return value; }
    bool     isAig() const { return type == AIG_GATE; }
+   bool     isPi() const { return type == PI_GATE; }
+   bool     isPo() const { return type == PO_GATE; }
+   bool     isConst() const { return type == CONST_GATE; }
+   bool     isUndef() const { return type == UNDEF_GATE; }
 
    virtual unsigned getFaninLit(int=0) const { return 0; }
+   // fanins as tagged pointers: 2 for AIG, 1 for PO, 0 otherwise
+   virtual unsigned faninSize() const { return 0; }
+   virtual size_t getFanin(unsigned) const { return 0; }
    virtual void getFloatingFanin(CirGate*&, CirGate*&) const {}
    virtual TwoFanins getFanins() const { return TwoFanins(0, 0); }
 
    // Printing functions
    virtual void printGate() const = 0;
-   virtual void writeGate(ostream&) const {}
-   virtual void countGate(unsigned&) const {}
    virtual void printFanin(int, int, bool) const;
    virtual void printFanout(int, int, bool) const;
    void reportGate() const;
@@ -66,6 +71,7 @@ public:
    // Returning gate status
    virtual bool haveFloatingFanin() const { return false; }
    bool definedNotUsed() const { return fanouts.empty(); }
+   const vector<size_t>& getFanouts() const { return fanouts; }
 
    // Setting fanins/fanouts
    virtual bool setFanin(CirGate*, bool=false, int=0) { return false; }
@@ -80,17 +86,13 @@ public:
    void mergeFRAIG(CirGate*, bool);
 
    // For DFS and BFS Traversing
-   virtual void dfsTraversal(GateList&) const = 0;
+   void dfsTraversal(GateList&) const;
    static  void resetGlobalRef() { _global_ref++; }
 
    // For CirMgr's use
    void setGateName(const string& gn) { gateName = gn; }
    void sortFanouts() { sort(fanouts.begin(), fanouts.end(), compareByID); }
 
-   // Run simulation
-   virtual void simulate(SimValue=0) { value = 0; }
-   void setSimValue(SimValue v, bool i) { value = v ^ i; }
-
    // Static helper methods
    static CirGate* unmask(size_t ptr) { return (CirGate*)(ptr / 2 * 2); }
    static bool isInverting(size_t ptr) { return ptr % 2; }
@@ -107,7 +109,6 @@ private:
 protected:
    string           gateName;
    vector<size_t>   fanouts;
-   SimValue         value;
    
    // For DFS Traversing
    bool isVisited() const { return _ref == _global_ref; }
@@ -122,17 +123,15 @@ public:
    unsigned getFaninLit(int) const;
    void getFloatingFanin(CirGate*&, CirGate*&) const;
    TwoFanins getFanins() const { return TwoFanins(fanin1, fanin2);}
-   void dfsTraversal(GateList&) const;
+   unsigned faninSize() const { return 2; }
+   size_t getFanin(unsigned i) const { return i == 0 ? fanin1 : fanin2; }
    void printGate() const;
-   void writeGate(ostream&) const;
-   void countGate(unsigned&) const;
    void printFanin(int, int, bool) const;
    bool haveFloatingFanin() const;
    bool setFanin(CirGate*, bool, int);
    void newFanin(CirGate*, CirGate*, bool);
    void trivialOpt(GateList&, CirGate*);
    void rmRelatingFanouts();
-   void simulate(SimValue);
 private:
    size_t fanin1;
    size_t fanin2;
@@ -143,9 +142,7 @@ class PIGate : public CirGate
 public:
    PIGate(unsigned i, unsigned ln) : CirGate(i, ln, PI_GATE) {}
    ~PIGate() {}
-   void dfsTraversal(GateList&) const;
    void printGate() const;
-   void simulate(SimValue v) { value = v; }
 };
 
 class POGate : public CirGate
@@ -154,11 +151,10 @@ public:
    POGate(unsigned i, unsigned ln) : CirGate(i, ln, PO_GATE) {}
    ~POGate() {}
    unsigned getFaninLit(int num) const { return (2 * unmask(fanin)->getID() + isInverting(fanin)); }
-   void getFloatingFanin(CirGate*& a, CirGate*&) const { if(unmask(fanin)->getTypeStr() == "UNDEF") a = unmask(fanin); }
-   void dfsTraversal(GateList&) const;
+   void getFloatingFanin(CirGate*& a, CirGate*&) const { if(unmask(fanin)->isUndef()) a = unmask(fanin); }
+   unsigned faninSize() const { return 1; }
+   size_t getFanin(unsigned) const { return fanin; }
    void printGate() const;
-   void writeGate(ostream& os) const { unmask(fanin)->writeGate(os); }
-   void countGate(unsigned& cnt) const { unmask(fanin)->countGate(cnt); }
    void printFanin(int, int, bool) const;
    void printFanout(int, int, bool) const;
    bool haveFloatingFanin() const;
@@ -166,7 +162,6 @@ public:
    bool setFanout(CirGate* cg, bool inv) { return false; }
    void newFanin(CirGate* o, CirGate* n, bool i) { setFanin(n, i != isInverting(fanin), 0); }
    void rmRelatingFanouts() { unmask(fanin)->removeFanout(this); }
-   void simulate(SimValue) { setSimValue(unmask(fanin)->getSimValue(), isInverting(fanin)); }
 private:
    size_t fanin;
 };
@@ -176,7 +171,6 @@ class UNDEFGate : public CirGate
 public:
    UNDEFGate(unsigned i) : CirGate(i, 0, UNDEF_GATE) {}
    ~UNDEFGate() {}
-   void dfsTraversal(GateList&) const { return; }
    void printGate() const { return; }
 };
 
@@ -185,7 +179,6 @@ class CONSTGate : public CirGate
 public:
    CONSTGate() : CirGate(0, 0, CONST_GATE) {}
    ~CONSTGate() {}
-   void dfsTraversal(GateList&) const;
    void printGate() const;
 };
 
@@ -13,6 +13,10 @@
 #include <ctype.h>
 #include <cassert>
 #include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
@@ -59,6 +63,42 @@ static string errMsg;
 static int errInt;
 static CirGate *errGate;
 
+// binary AIGER deltas: 7 bits per byte, low bits first, MSB set on all but
+// the last byte
+static bool
+readAigDelta(istream& is, unsigned& x)
+{
+   x = 0;
+   for(unsigned shift = 0; shift < 32; shift += 7) {
+      int c = is.get();
+      if(c == EOF) return false;
+      x |= unsigned(c & 0x7f) << shift;
+      if((c & 0x80) == 0) return true;
+   }
+   return false;
+}
+
+// decimal without sign or overflow (at most 9 digits)
+static inline bool
+scanUnsigned(const char*& p, const char* end, unsigned& x)
+{
+   const char* b = p;
+   x = 0;
+   while(p != end && *p >= '0' && *p <= '9' && p - b < 9)
+      x = x * 10 + (*p++ - '0');
+   return p != b && (p == end || *p < '0' || *p > '9');
+}
+
+static void
+writeAigDelta(ostream& os, unsigned x)
+{
+   while(x & ~0x7fu) {
+      os.put(char((x & 0x7f) | 0x80));
+      x >>= 7;
+   }
+   os.put(char(x));
+}
+
 static bool
 parseError(CirParseError err)
 {
@@ -161,36 +201,169 @@ CirMgr::~CirMgr() {
    delete constGate;
    for(unsigned i = 0; i < fecGrps.size(); i++)
       delete fecGrps[i];
+   for(unsigned i = 0; i < _satModels.size(); i++)
+      delete _satModels[i];
 }
 
+// O(1): the phase is that of the gate's entry relative to the first one
 size_t 
 CirMgr::getFECGrp(unsigned gid) const 
 {
-   if(!simulated) return 0;
-   FECGroup* ret;
-   if(fecGrpMap[gid] == 0) return 0;
-   else ret = fecGrps[fecGrpMap[gid] - 1];
-   for(unsigned i = 0; i < ret->size(); i++) {
-      if(CirGate::unmask((*ret)[i]) == getGate(gid)) 
-         return size_t(ret) ^ 
-            ((CirGate::isInverting((*ret)[i]) !=
-             CirGate::isInverting((*ret)[0])) ? 0x1 : 0);
-   }
-   cerr << gid << '\n';
-   assert(0);
+   if(!simulated || fecGrpMap[gid] == 0) return 0;
+   const FECGroup* ret = fecGrps[fecGrpMap[gid] - 1];
+   assert(CirGate::unmask((*ret)[fecGrpPos[gid]]) == getGate(gid));
+   return size_t(ret) ^ ((CirGate::isInverting((*ret)[fecGrpPos[gid]]) !=
+                          CirGate::isInverting((*ret)[0])) ? 0x1 : 0);
 }
 
+// The fast parser accepts only well-formed files and leaves the manager
+// untouched otherwise; the strict parser then reports the exact error
 bool
 CirMgr::readCircuit(const string& fileName)
 {
    constGate = new CONSTGate();
+   if(readCircuitFast(fileName)) return true;
+   return readCircuitStrict(fileName);
+}
 
+// mmap-based parser for well-formed ASCII AIGER; any anomaly (including
+// anything the strict parser would report) returns false before a gate is
+// created
+bool
+CirMgr::readCircuitFast(const string& fileName)
+{
+   int fd = open(fileName.c_str(), O_RDONLY);
+   if(fd < 0) return false;
+   struct stat st;
+   if(fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+   size_t size = st.st_size;
+   char* base = (char*)mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(base == MAP_FAILED) return false;
+   madvise(base, size, MADV_SEQUENTIAL);
+
+   const char *p = base, *end = base + size;
+   bool ok = false;
+   unsigned hdr[5];
+   IdList piID, outID, andID, fin1ID, fin2ID;
+   vector<unsigned char> defined;
+   vector<pair<unsigned, string>> names;   // (2 * index + isPO, name)
+
+   do {
+      // Header
+      if(end - p < 4 || memcmp(p, "aag ", 4) != 0) break;
+      p += 4;
+      unsigned i = 0;
+      for(; i < 5; i++) {
+         if(!scanUnsigned(p, end, hdr[i])) break;
+         if(p == end || *p++ != (i < 4 ? ' ' : '\n')) break;
+      }
+      if(i != 5) break;
+      unsigned mvi = hdr[0], inNo = hdr[1], outNo = hdr[3], andNo = hdr[4];
+      if(hdr[2] != 0 || mvi < inNo + andNo) break;
+      defined.assign(mvi + 1, 0);
+      defined[0] = 1;
+
+      // Input pins
+      piID.resize(inNo);
+      for(i = 0; i < inNo; i++) {
+         unsigned id;
+         if(!scanUnsigned(p, end, id) || p == end || *p++ != '\n') break;
+         if(id < 2 || (id & 1) || id / 2 > mvi || defined[id / 2]) break;
+         defined[id / 2] = 1;
+         piID[i] = id;
+      }
+      if(i != inNo) break;
+
+      // Output pins
+      outID.resize(outNo);
+      for(i = 0; i < outNo; i++) {
+         unsigned id;
+         if(!scanUnsigned(p, end, id) || p == end || *p++ != '\n') break;
+         if(id / 2 > mvi) break;
+         outID[i] = id;
+      }
+      if(i != outNo) break;
+
+      // And Gates
+      andID.resize(andNo); fin1ID.resize(andNo); fin2ID.resize(andNo);
+      for(i = 0; i < andNo; i++) {
+         unsigned id, f1, f2;
+         if(!scanUnsigned(p, end, id) || p == end || *p++ != ' ') break;
+         if(!scanUnsigned(p, end, f1) || p == end || *p++ != ' ') break;
+         if(!scanUnsigned(p, end, f2) || p == end || *p++ != '\n') break;
+         if(id < 2 || (id & 1) || id / 2 > mvi || defined[id / 2]) break;
+         if(f1 / 2 > mvi || f2 / 2 > mvi) break;
+         defined[id / 2] = 1;
+         andID[i] = id; fin1ID[i] = f1; fin2ID[i] = f2;
+      }
+      if(i != andNo) break;
+
+      // Pin Names, up to a "c" line or the end of file
+      vector<unsigned char> named(inNo + outNo, 0);
+      bool bad = false;
+      while(p != end && *p != 'c') {
+         const char* line = p;
+         bool outpin = (*p == 'o');
+         unsigned idx;
+         if(*p != 'i' && *p != 'o') { bad = true; break; }
+         ++p;
+         if(!scanUnsigned(p, end, idx) || p == end || *p++ != ' ') {
+            bad = true; break; }
+         if(idx >= (outpin ? outNo : inNo)) { bad = true; break; }
+         unsigned slot = outpin ? inNo + idx : idx;
+         if(named[slot]) { bad = true; break; }
+         named[slot] = 1;
+         const char* name = p;
+         while(p != end && *p != '\n' && isprint(*p)) p++;
+         if(p == name || p == end || *p != '\n' || p - line >= 1023) {
+            bad = true; break; }
+         names.push_back(make_pair(2 * idx + outpin, string(name, p - name)));
+         p++;
+      }
+      if(bad) break;
+      // the strict parser wants the "c" alone on its line
+      if(p != end && !(end - p == 1 || p[1] == '\n')) break;
+      ok = true;
+   } while(false);
+
+   munmap(base, size);
+   if(!ok) return false;
+
+   unsigned mvi = hdr[0], inNo = hdr[1], outNo = hdr[3], andNo = hdr[4];
+   gateMap.resize(mvi + outNo + 1, 0);
+   gateMap[0] = constGate;
+   for(unsigned i = 0; i < inNo; i++) {
+      PIs.push_back(new PIGate(piID[i] / 2, i + 2));
+      gateMap[piID[i] / 2] = PIs.back();
+   }
+   for(unsigned i = 0; i < outNo; i++) {
+      POs.push_back(new POGate(mvi + i + 1, i + inNo + 2));
+      gateMap[mvi + i + 1] = POs.back();
+   }
+   for(unsigned i = 0; i < andNo; i++) {
+      AIGs.push_back(new AIGGate(andID[i] / 2, i + inNo + outNo + 2));
+      gateMap[andID[i] / 2] = AIGs.back();
+   }
+   for(unsigned i = 0; i < names.size(); i++) {
+      unsigned idx = names[i].first / 2;
+      if(names[i].first & 1) POs[idx]->setGateName(names[i].second);
+      else PIs[idx]->setGateName(names[i].second);
+   }
+
+   connectCircuit(outID, fin1ID, fin2ID);
+   return true;
+}
+
+bool
+CirMgr::readCircuitStrict(const string& fileName)
+{
    lineNo = 0; colNo = 0;
    errMsg = ""; errInt = 0;
    memset(buf, 0, 1024);
 
    // Open file
-   ifstream ifs(fileName);
+   ifstream ifs(fileName, ios::in | ios::binary);
    if(!ifs) { 
       cerr << "Cannot open design \"" << fileName << "\"!!\n";
       return false; }
@@ -207,12 +380,14 @@ CirMgr::readCircuit(const string& fileName)
    if(buf[colNo] == ' ') return parseError(EXTRA_SPACE);
    if(isspace(buf[colNo]))  return parseError(ILLEGAL_WSPACE);
    errMsg = ""; for(int i = 0; buf[i] != 0 && !isspace(buf[i]); i++) errMsg += buf[i];
+   // "aig" is binary AIGER: implicit PIs and delta-encoded AND gates
+   bool binary = (errMsg == "aig");
    if(buf[colNo] != 'a')   return parseError(ILLEGAL_IDENTIFIER);
-   if(buf[++colNo] != 'a') return parseError(ILLEGAL_IDENTIFIER);
+   if(buf[++colNo] != (binary ? 'i' : 'a')) return parseError(ILLEGAL_IDENTIFIER);
    if(buf[++colNo] != 'g') return parseError(ILLEGAL_IDENTIFIER);
 
    if(buf[++colNo] >= '0' && buf[colNo] <= '9') return parseError(MISSING_SPACE);
-   if(errMsg != "aag") return parseError(ILLEGAL_IDENTIFIER);
+   if(errMsg != "aag" && !binary) return parseError(ILLEGAL_IDENTIFIER);
 
    for(int i = 0; i < 5; i++) {
       string type;
@@ -261,12 +436,21 @@ CirMgr::readCircuit(const string& fileName)
       errMsg = "latches";
       return parseError(ILLEGAL_NUM); }
 
+   if(binary && mvi > inNo + andNo) {
+      errMsg = "Number of variables";
+      errInt = mvi;
+      return parseError(NUM_TOO_BIG); }
+
    // gateMap = new CirGate* [mvi + outNo + 1] {0};
    gateMap.resize(mvi + outNo + 1, 0);
    gateMap[0] = constGate;
 
    // Input pins
-   for(unsigned i = 0; i < inNo; i++) {
+   for(unsigned i = 0; binary && i < inNo; i++) {
+      PIs.push_back(new PIGate(i + 1, i + 2));
+      gateMap[i + 1] = PIs.back();
+   }
+   for(unsigned i = 0; !binary && i < inNo; i++) {
 
       lineNo++; colNo = 0;
       errMsg = ""; errInt = 0; errGate = 0;
@@ -342,7 +526,30 @@ CirMgr::readCircuit(const string& fileName)
 
    // And Gates
    vector<unsigned> andID, fin1ID, fin2ID;
-   for(unsigned i = 0; i < andNo; i++) {
+   for(unsigned i = 0; binary && i < andNo; i++) {
+
+      lineNo++; colNo = 0;
+      errMsg = ""; errInt = 0; errGate = 0;
+
+      unsigned id = 2 * (inNo + i + 1), delta0, delta1;
+
+      errMsg = "AIG";
+      if(!readAigDelta(ifs, delta0) || !readAigDelta(ifs, delta1))
+         return parseError(MISSING_DEF);
+      errInt = delta0;
+      errMsg = "AIG input literal delta(" + to_string(delta0) + ")";
+      if(delta0 == 0 || delta0 > id) return parseError(ILLEGAL_NUM);
+      errInt = delta1;
+      errMsg = "AIG input literal delta(" + to_string(delta1) + ")";
+      if(delta1 > id - delta0)       return parseError(ILLEGAL_NUM);
+
+      AIGs.push_back(new AIGGate(id / 2, i + inNo + outNo + 2));
+      gateMap[id / 2] = AIGs.back();
+      andID.push_back(id);
+      fin1ID.push_back(id - delta0);
+      fin2ID.push_back(id - delta0 - delta1);
+   }
+   for(unsigned i = 0; !binary && i < andNo; i++) {
       
       lineNo++; colNo = 0;
       errMsg = ""; errInt = 0; errGate = 0;
@@ -492,6 +699,19 @@ CirMgr::readCircuit(const string& fileName)
 
    if(buf[++colNo] != 0) return parseError(MISSING_NEWLINE);
 
+   connectCircuit(outID, fin1ID, fin2ID);
+
+   return true;
+}
+
+// Create the fanin/fanout links of the parsed AIGs and POs from their fanin
+// literals; undefined fanins become UNDEF gates
+void
+CirMgr::connectCircuit(const IdList& outID, const IdList& fin1ID,
+                       const IdList& fin2ID)
+{
+   unsigned andNo = AIGs.size(), outNo = POs.size();
+
    // Set fanins of AND gates
    for(unsigned i = 0; i < andNo; i++) {
       unsigned fanin1ID = fin1ID[i] / 2;
@@ -539,8 +759,6 @@ CirMgr::readCircuit(const string& fileName)
 
    sortAllFanouts();
    DFS();
-
-   return true;
 }
 
 void
@@ -551,6 +769,8 @@ CirMgr::DFS()
    for(unsigned i = 0; i < POs.size(); i++) {
       POs[i]->dfsTraversal(_dfsList);
    }
+   _aig.build(gateMap, _dfsList);
+   _mergedInto.assign(gateMap.size(), 0);
 }
 
 void
@@ -698,18 +918,17 @@ CirMgr::printFECPairs() const
 void
 CirMgr::writeAag(ostream& outfile) const
 {
-   // Header
-   unsigned aigcnt = 0;
-   CirGate::resetGlobalRef();
-   for(unsigned i = 0; i < POs.size(); i++) 
-      POs[i]->countGate(aigcnt);
-
-   outfile << "aag " << gateMap.size() - POs.size() - 1 << " "
+   // Header; AIGs added by rewriting are numbered after the POs
+   unsigned maxVar = gateMap.size() - POs.size() - 1;
+   if(!POs.empty()) maxVar = POs[0]->getID() - 1;
+   const IdList& aigs = _aig.aigList();
+   for(unsigned i = 0; i < aigs.size(); i++)
+      if(aigs[i] > maxVar) maxVar = aigs[i];
+   outfile << "aag " << maxVar << " "
            << PIs.size() << " 0 "
            << POs.size() << " "
-           << aigcnt << "\n";
+           << aigs.size() << "\n";
 
-   CirGate::resetGlobalRef();
    // Inputs
    for(unsigned i = 0; i < PIs.size(); i++)
       outfile << 2 * PIs[i]->getID() << "\n";
@@ -719,8 +938,64 @@ CirMgr::writeAag(ostream& outfile) const
       outfile << POs[i]->getFaninLit() << "\n";
 
    // And gates
-   for(unsigned i = 0; i < POs.size(); i++) 
-      POs[i]->writeGate(outfile);
+   for(unsigned i = 0; i < _dfsList.size(); i++) {
+      if(!_dfsList[i]->isAig()) continue;
+      outfile << 2 * _dfsList[i]->getID() << " "
+              << _dfsList[i]->getFaninLit(1) << " "
+              << _dfsList[i]->getFaninLit(2) << "\n";
+   }
+
+   // Symbolic names
+   for(unsigned i = 0; i < PIs.size(); i++) {
+      if(PIs[i]->getGateName().size() != 0) {
+         outfile << "i" << i << " "
+                 << PIs[i]->getGateName() << "\n";
+      }
+   }
+   for(unsigned i = 0; i < POs.size(); i++) {
+      if(POs[i]->getGateName().size() != 0) {
+         outfile << "o" << i << " "
+                 << POs[i]->getGateName() << "\n";
+      }
+   }
+
+   outfile << "c" << endl;
+}
+
+// Binary AIGER: PIs are renumbered 1..I and the AIGs reachable from the
+// POs I+1..I+A in topological order. AIGER has no undefined variables, so
+// floating fanins are written as constant 0, the value they simulate to
+void
+CirMgr::writeAig(ostream& outfile) const
+{
+   const IdList& aigs = _aig.aigList();
+   IdList newVar(gateMap.size(), 0);
+   for(unsigned i = 0; i < PIs.size(); i++)
+      newVar[PIs[i]->getID()] = i + 1;
+   for(unsigned i = 0; i < aigs.size(); i++)
+      newVar[aigs[i]] = PIs.size() + i + 1;
+
+   outfile << "aig " << PIs.size() + aigs.size() << " "
+           << PIs.size() << " 0 "
+           << POs.size() << " "
+           << aigs.size() << "\n";
+
+   // Outputs
+   for(unsigned i = 0; i < POs.size(); i++) {
+      unsigned lit = _aig.fanin0(POs[i]->getID());
+      outfile << 2 * newVar[CirAig::var(lit)] + CirAig::isInv(lit) << "\n";
+   }
+
+   // And gates
+   for(unsigned i = 0; i < aigs.size(); i++) {
+      unsigned a = _aig.fanin0(aigs[i]), b = _aig.fanin1(aigs[i]);
+      unsigned lhs = 2 * newVar[aigs[i]];
+      unsigned r0 = 2 * newVar[CirAig::var(a)] + CirAig::isInv(a);
+      unsigned r1 = 2 * newVar[CirAig::var(b)] + CirAig::isInv(b);
+      if(r0 < r1) { unsigned t = r0; r0 = r1; r1 = t; }
+      writeAigDelta(outfile, lhs - r0);
+      writeAigDelta(outfile, r0 - r1);
+   }
 
    // Symbolic names
    for(unsigned i = 0; i < PIs.size(); i++) {
@@ -750,8 +1025,8 @@ CirMgr::writeGate(ostream& outfile, CirGate *g) const
    unsigned _a = 0;
    for(unsigned i = 0; i < _list.size(); i++) {
       if(_list[i]->getID() > _m) _m = _list[i]->getID();
-      if(_list[i]->getTypeStr() == "PI") _i++;
-      if(_list[i]->getTypeStr() == "AIG") _a++;
+      if(_list[i]->isPi()) _i++;
+      if(_list[i]->isAig()) _a++;
    }
 
    outfile << "aag " << _m << " "
@@ -759,12 +1034,11 @@ CirMgr::writeGate(ostream& outfile, CirGate *g) const
            << "1" << " "
            << _a << "\n";
 
-   CirGate::resetGlobalRef();
    // Inputs
    vector<bool> PIMap;
    PIMap.resize(gateMap.size(), false);
    for(unsigned i = 0; i < _list.size(); i++)
-      if(_list[i]->getTypeStr() == "PI")
+      if(_list[i]->isPi())
          PIMap[_list[i]->getID()] = true;
 
    for(unsigned i = 0; i < PIs.size(); i++)
@@ -775,7 +1049,12 @@ CirMgr::writeGate(ostream& outfile, CirGate *g) const
    outfile << g->getID() * 2 << "\n";
 
    // And gates
-   g->writeGate(outfile);
+   for(unsigned i = 0; i < _list.size(); i++) {
+      if(!_list[i]->isAig()) continue;
+      outfile << 2 * _list[i]->getID() << " "
+              << _list[i]->getFaninLit(1) << " "
+              << _list[i]->getFaninLit(2) << "\n";
+   }
 
    // Symbolic names
    unsigned j = 0;
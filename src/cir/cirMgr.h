@@ -19,6 +19,9 @@ using namespace std;
 // TODO: Feel free to define your own classes, variables, or functions.
 
 #include "cirDef.h"
+#include "cirAig.h"
+#include "cirStrash.h"
+#include "cirRewrite.h"
 #include "sat.h"
 
 extern CirMgr *cirMgr;
@@ -26,7 +29,9 @@ extern CirMgr *cirMgr;
 class CirMgr
 {
 public:
-   CirMgr() : _simLog(0), simulated(false), _effort(MEDIUM_EFF) {}
+   CirMgr() : _simLog(0), _simLogBinary(false), _simLogPatterns(0),
+              _strashed(false), simulated(false), _effort(MEDIUM_EFF),
+              _simWidth(1), _simThreads(1), _simWords(0), _simLastWord(0) {}
    ~CirMgr();
 
    // Access functions
@@ -36,6 +41,11 @@ public:
       return gateMap[gid];
    }
    size_t getFECGrp(unsigned gid) const;
+   // value of the word holding the last pattern simulated
+   SimValue getSimValue(unsigned gid) const {
+      if(_simWords == 0) return 0;
+      return _simData[gid * _simWords + _simLastWord];
+   }
 
    // Member functions about circuit construction
    bool readCircuit(const string&);
@@ -43,17 +53,27 @@ public:
    // Member functions about circuit optimization
    void sweep();
    void optimize();
+   void rewrite();
+   void replaceGate(CirGate*, size_t);
 
    // Member functions about simulation
    void randomSim();
-   void fileSim(ifstream&);
-   void setSimLog(ofstream *logFile) { _simLog = logFile; }
+   void fileSim(const string&);
+   void setSimLog(ofstream *logFile, bool binary = false) {
+      _simLog = logFile; _simLogBinary = binary; _simLogPatterns = 0;
+   }
    void setEffort(Effort eff) { _effort = eff; }
+   // number of 64-bit pattern words simulated per pass
+   void setSimWidth(unsigned words) { _simWidth = words; }
+   // worker threads sharing the pattern words of each pass
+   void setSimThreads(unsigned n) { _simThreads = n; }
 
    // Member functions about fraig
    void strash();
    void printFEC() const;
-   void fraig();
+   // nThreads > 1: prove FEC pairs in parallel with one SATModel per thread
+   // piDecision: the SAT solver only branches on PIs
+   void fraig(unsigned nThreads = 1, bool piDecision = false);
 
    // Member functions about circuit reporting
    void printSummary() const;
@@ -63,11 +83,14 @@ public:
    void printFloatGates() const;
    void printFECPairs() const;
    void writeAag(ostream&) const;
+   void writeAig(ostream&) const;
    void writeGate(ostream&, CirGate*) const;
 
 
 private:
    ofstream           *_simLog;
+   bool               _simLogBinary;
+   size_t             _simLogPatterns;
 
    GateList           PIs;
    GateList           POs;
@@ -77,46 +100,142 @@ private:
 
    GateList           gateMap;
    GateList           _dfsList;
+   CirAig             _aig;
+
+   // unique table of the AIGs, kept up to date by replaceGate() once
+   // strash() has built it
+   AigHash            _strashTable;
+   bool               _strashed;
+   // the (tagged) gate each gate merged since the last DFS() was replaced by
+   vector<size_t>     _mergedInto;
 
    vector<FECGroup*>  fecGrps;
-   IdList             fecGrpMap;
+   IdList             fecGrpMap;   // group index + 1 of every gate; 0: none
+   IdList             fecGrpPos;   // position of every gate in its group
 
    bool               simulated;
    Effort             _effort;
 
+   // simulation buffer: _simWords words per gate, indexed by gate ID
+   unsigned           _simWidth;
+   unsigned           _simThreads;
+   unsigned           _simWords;
+   unsigned           _simLastWord;
+   vector<size_t>     _simData;
+
+   // incremental SAT contexts of fraig(), one per thread
+   vector<SATModel*>  _satModels;
+
+   // Member functions about circuit reading
+   bool readCircuitFast(const string&);
+   bool readCircuitStrict(const string&);
+   void connectCircuit(const IdList&, const IdList&, const IdList&);
+
    // Update info of gates
    void DFS();
    void updateGateLists();
    void sortAllFanouts();
+   size_t liveGate(size_t) const;
+   void unhash(CirGate*);
+
+   // Member functions about rewriting
+   void rewriteGate(unsigned, RwState&);
+   void computeCuts(unsigned, RwState&);
+   bool isCutOf(unsigned, const RwCut&, RwState&);
+   unsigned derefMFFC(unsigned, const RwCut&, RwState&);
+   void clearMarks(RwState&);
+   unsigned countRewrite(unsigned, const RwCut&, unsigned, RwState&);
+   unsigned buildRewrite(const RwCut&, RwState&);
+   unsigned lookupAnd(unsigned, unsigned) const;
+   unsigned newAig(unsigned, unsigned);
+   void removeDangling(CirGate*);
 
    // Member functions about simulation
    void sortFECGrps();
    void resetFECGrps();
    void simulateAll(const vector<SimValue>&);
+   void simulateAll(const size_t*, unsigned);
+   void simulateWords(const size_t*, unsigned, unsigned);
    void identifyFECs();
+   void refineFECGrp(unsigned);
+   void mapFECGrp(unsigned, unsigned from = 0);
    void writeSimulationLog(unsigned);
+   void closeSimulationLog();
+   const size_t* getSimRow(size_t) const;
    bool randomCheckPoint() const;
 
    // Member functions about fraig
+   void fraigSerial(bool);
+   void fraigParallel(unsigned, bool);
+   void prepareSATModels(unsigned, bool);
+   void proveFraigBatch(const vector<SATModel*>&,
+                        const vector<pair<size_t, size_t>>&, int64,
+                        vector<pair<size_t, size_t>>&);
+   void retryFraigPairs(const vector<SATModel*>&,
+                        vector<pair<size_t, size_t>>&);
+   void simulateCex(const vector<size_t>&);
+   void separateSatPairs(const vector<pair<unsigned, unsigned>>&);
    void deleteFromFECGrp(CirGate*);
+   void mergeEquivalent(size_t, size_t);
 
    // Helper access methods
    void DFS(CirGate*, GateList&) const;
    GateList getSortedDFSList() const;
 };
 
+// Only the cones of the gates passed to prove() are loaded; gates outside
+// them (e.g. PIs no proof has reached) read as 0.
+// With "piDecision", only PI vars are decision vars; every gate var is
+// implied once its PIs are assigned
 class SATModel
 {
    friend class CirMgr;
 public:
-   SATModel(unsigned sz) { solver.initialize(); varMap.resize(sz); }
-   void setGate(CirGate*);
-   bool prove(size_t, size_t);
-
-   int getValue(unsigned i) { return solver.getValue(varMap[i]); }
+   SATModel(const CirAig& aig, bool piDecision = false)
+      : _aig(aig), _piDecision(piDecision), _byTable(false),
+        _nDeadClauses(0) {
+      solver.initialize(); varMap.assign(aig.size(), var_Undef);
+      _loaded.assign(aig.size(), false); setGate(0);
+      _mark.assign(aig.size(), 0); _flip.assign(aig.size(), 0);
+      _tablePos.assign(aig.size(), 0); _tableValue.assign(aig.size(), 0);
+   }
+   // "conflicts" < 0: no budget
+   SatResult prove(size_t, size_t, int64 conflicts = -1);
+   // to be called before reusing the model on a changed netlist
+   void update(bool piDecision);
+
+   int getValue(unsigned i) {
+      if(_byTable) return _tableValue[i];
+      return _loaded[i] ? solver.getValue(varMap[i]) : 0;
+   }
+   // counterexample of the last SAT prove(a, b), as words[j] of PIs[j]
+   void getCexWords(size_t a, size_t b, const GateList& PIs, size_t* words);
 private:
-   SatSolver   solver;
-   vector<Var> varMap;
+   void setGate(unsigned);
+   void loadCone(unsigned);
+   SatResult proveByTable(size_t, size_t);
+   // UNDEF fanins are treated as CONST 0
+   unsigned faninVar(unsigned lit) const {
+      unsigned v = CirAig::var(lit);
+      return _aig.type(v) == UNDEF_GATE ? 0 : v;
+   }
+
+   const CirAig& _aig;
+   bool          _piDecision;
+   SatSolver     solver;
+   vector<Var>   varMap;
+   vector<bool>  _loaded;
+   IdList        _stack;
+   IdList        _visited;
+   vector<char>  _mark;
+   vector<size_t> _flip;
+   // truth tables of the last proveByTable() cone, and its counterexample
+   bool          _byTable;       // the last prove() did not use the solver
+   vector<size_t> _table;
+   IdList        _tablePos;
+   vector<char>  _tableValue;
+   IdList        _tableOnes;     // PIs that are 1 in _tableValue
+   unsigned      _nDeadClauses;  // retired miter clauses not yet collected
 };
 
 #endif // CIR_MGR_H
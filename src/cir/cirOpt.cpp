@@ -37,11 +37,11 @@ CirMgr::sweep()
    for(unsigned i = 1; i < gateMap.size(); i++) {
       if(gateMap[i] != sortedDFSList[i]) {
          assert(sortedDFSList[i] == 0);
-         string type = gateMap[i]->getTypeStr();
-         if(type == "PI") continue;
-         assert(type != "PO");
-         cout << "Sweeping: " << type << "(" 
+         if(gateMap[i]->isPi()) continue;
+         assert(!gateMap[i]->isPo());
+         cout << "Sweeping: " << gateMap[i]->getTypeStr() << "(" 
               << i << ") removed..." << endl;
+         unhash(gateMap[i]);
          gateMap[i]->rmRelatingFanouts();
          gateMap[i] = 0;
       }
@@ -56,10 +56,10 @@ CirMgr::sweep()
 void
 CirMgr::optimize()
 {
-   for(unsigned i = 1; i < _dfsList.size(); i++) {
-      if(_dfsList[i]->getTypeStr() == "AIG")
-         _dfsList[i]->trivialOpt(gateMap, constGate);
-   }
+   const IdList& aigs = _aig.aigList();
+   for(unsigned i = 0; i < aigs.size(); i++)
+      if(gateMap[aigs[i]] != 0)   // not strashed into another gate
+         gateMap[aigs[i]]->trivialOpt(gateMap, constGate);
    updateGateLists();
    sortAllFanouts();
    DFS();
@@ -102,11 +102,11 @@ AIGGate::trivialOpt(GateList& gateMap, CirGate* constGate)
    
    //printGate();
 
-   if(unmask(fanin1)->getTypeStr() == "CONST") { // Fanin1 is constant
+   if(unmask(fanin1)->isConst()) { // Fanin1 is constant
       if(isInverting(fanin1)) replacing = true;
       else const0 = true;
    }
-   else if(unmask(fanin2)->getTypeStr() == "CONST") {
+   else if(unmask(fanin2)->isConst()) {
       replaceL = true;
       if(isInverting(fanin2)) replacing = true;
       else const0 = true;
@@ -119,22 +119,8 @@ AIGGate::trivialOpt(GateList& gateMap, CirGate* constGate)
    }
 
    size_t fanin;
-   if(const0) {
-      rmRelatingFanouts();
-      for(unsigned i = 0; i < fanouts.size(); i++) {
-         unmask(fanouts[i])->newFanin(this, cirMgr->getGate(0), false);
-         constGate->setFanout(unmask(fanouts[i]), isInverting(fanouts[i]));
-      }
-   }
-   else if(replacing) {
-      rmRelatingFanouts();
-      if(replaceL) fanin = fanin1;
-      else         fanin = fanin2;
-      for(unsigned i = 0; i < fanouts.size(); i++) {
-         unmask(fanouts[i])->newFanin(this, unmask(fanin), isInverting(fanin));
-         unmask(fanin)->setFanout(unmask(fanouts[i]), isInverting(fanin) != isInverting(fanouts[i]));
-      }
-   }
+   if(const0) fanin = size_t(constGate);
+   else if(replacing) fanin = replaceL ? fanin1 : fanin2;
    else return;
 
    cout << "Simplifying: ";
@@ -144,7 +130,8 @@ AIGGate::trivialOpt(GateList& gateMap, CirGate* constGate)
    if(!const0 && isInverting(fanin)) cout << "!";
    cout << getID() << "..." << endl;
 
-   gateMap[getID()] = 0;
+   // also strashes the fanouts on their new fanins
+   cirMgr->replaceGate(this, fanin);
 }
 
 GateList
@@ -0,0 +1,220 @@
+/****************************************************************************
+  FileName     [ cirPattern.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define text/binary simulation pattern file helpers ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "cirPattern.h"
+
+using namespace std;
+
+/**************************************/
+/*   Pattern file header functions    */
+/**************************************/
+bool
+isBinaryPattern(const char* data, size_t size)
+{
+   return size >= 8 && memcmp(data, PATTERN_MAGIC, 8) == 0;
+}
+
+bool
+readPatternHeader(const char* data, size_t size, PatternHeader& h)
+{
+   if(size < sizeof(PatternHeader)) return false;
+   memcpy(&h, data, sizeof(PatternHeader));
+   return memcmp(h.magic, PATTERN_MAGIC, 8) == 0 &&
+          h.version == PATTERN_VERSION && h.blockWords != 0;
+}
+
+void
+initPatternHeader(PatternHeader& h, unsigned nPIs, unsigned nPOs,
+                  unsigned blockWords)
+{
+   memcpy(h.magic, PATTERN_MAGIC, 8);
+   h.version = PATTERN_VERSION;
+   h.nPIs = nPIs;
+   h.nPOs = nPOs;
+   h.blockWords = blockWords;
+   h.nPatterns = 0;
+}
+
+/**************************************/
+/*   Text pattern parsing functions   */
+/**************************************/
+bool
+checkPattern(const char* p, size_t len, size_t nPIs)
+{
+   if(len != nPIs) {
+      cerr << "\nError: Pattern(" << string(p, len)
+           << ") length(" << len
+           << ") does not match the number of inputs("
+           << nPIs << ") in a circuit!!\n";
+      return false;
+   }
+   // eight characters at a time: '0' and '1' only differ in bit 0
+   size_t j = 0;
+   for(; j + 8 <= len; j += 8) {
+      uint64_t x;
+      memcpy(&x, p + j, 8);
+      if((x & 0xfefefefefefefefeULL) != 0x3030303030303030ULL) break;
+   }
+   for(; j < len; j++) {
+      if(p[j] != '0' && p[j] != '1') {
+         cerr << "\nError: Pattern(" << string(p, len)
+              << ") contains a non-0/1 character(\'"
+              << p[j] << "\').\n";
+         return false;
+      }
+   }
+   return true;
+}
+
+// Pattern k of lines[] goes to bit (63 - k % 64) of word (k / 64) of each
+// PI's row in "out". Eight lines by eight PIs are transposed at once: the
+// characters are loaded as 0/1 bytes (little-endian), line r is shifted left
+// by (7 - r), and OR-ing the eight lines leaves PI c's 8 bits in byte c
+void
+transposePatterns(const char* const* lines, unsigned n, unsigned nPIs,
+                  unsigned nWords, size_t* out)
+{
+   const uint64_t ones = 0x0101010101010101ULL;
+   for(unsigned k0 = 0; k0 < n; k0 += 8) {
+      unsigned w = k0 / 64, shift = 56 - k0 % 64;
+      unsigned nl = (n - k0 < 8) ? n - k0 : 8;
+      unsigned c = 0;
+      for(; c + 8 <= nPIs; c += 8) {
+         uint64_t acc = 0;
+         for(unsigned r = 0; r < nl; r++) {
+            uint64_t x;
+            memcpy(&x, lines[k0 + r] + c, 8);
+            acc |= (x & ones) << (7 - r);
+         }
+         for(unsigned b = 0; b < 8; b++)
+            out[(c + b) * nWords + w] |= ((acc >> (8 * b)) & 0xff) << shift;
+      }
+      for(; c < nPIs; c++) {
+         size_t byte = 0;
+         for(unsigned r = 0; r < nl; r++)
+            byte |= size_t(lines[k0 + r][c] & 1) << (7 - r);
+         out[c * nWords + w] |= byte << shift;
+      }
+   }
+}
+
+/**************************************/
+/*   Text <-> binary conversion       */
+/**************************************/
+// Text lines are "<PI bits>" or "<PI bits> <PO bits>" (the -Output log)
+static bool
+textToBinary(ifstream& in, ofstream& out)
+{
+   const unsigned nWords = PATTERN_BLOCK_WORDS;
+   const unsigned blockSize = nWords * 64;
+   vector<string> pis(blockSize), pos(blockSize);
+   vector<const char*> piLines(blockSize), poLines(blockSize);
+   vector<size_t> rows;
+
+   PatternHeader h;
+   bool first = true;
+   string line;
+   while(true) {
+      unsigned n = 0;
+      for(; n < blockSize && getline(in, line); ) {
+         size_t b = 0, e;
+         while(b < line.size() && isPatternSpace(line[b])) b++;
+         if(b == line.size()) continue;
+         for(e = b; e < line.size() && !isPatternSpace(line[e]); e++) ;
+         pis[n].assign(line, b, e - b);
+         for(b = e; b < line.size() && isPatternSpace(line[b]); b++) ;
+         for(e = b; e < line.size() && !isPatternSpace(line[e]); e++) ;
+         pos[n].assign(line, b, e - b);
+         if(first) {
+            initPatternHeader(h, pis[0].size(), pos[0].size(), nWords);
+            out.write((const char*)&h, sizeof(h));
+            rows.resize((h.nPIs + h.nPOs) * nWords);
+            first = false;
+         }
+         if(!checkPattern(pis[n].data(), pis[n].size(), h.nPIs) ||
+            !checkPattern(pos[n].data(), pos[n].size(), h.nPOs))
+            return false;
+         piLines[n] = pis[n].data();
+         poLines[n] = pos[n].data();
+         n++;
+      }
+      if(n == 0) break;
+      fill(rows.begin(), rows.end(), 0);
+      transposePatterns(&piLines[0], n, h.nPIs, nWords, &rows[0]);
+      transposePatterns(&poLines[0], n, h.nPOs, nWords,
+                        &rows[h.nPIs * nWords]);
+      out.write((const char*)&rows[0], rows.size() * sizeof(size_t));
+      h.nPatterns += n;
+      if(n < blockSize) break;
+   }
+   if(first) {
+      initPatternHeader(h, 0, 0, nWords);
+      out.write((const char*)&h, sizeof(h));
+   }
+   out.seekp(0);
+   out.write((const char*)&h, sizeof(h));
+   return true;
+}
+
+static bool
+binaryToText(ifstream& in, ofstream& out)
+{
+   PatternHeader h;
+   char buf[sizeof(PatternHeader)];
+   if(!in.read(buf, sizeof(buf)) || !readPatternHeader(buf, sizeof(buf), h)) {
+      cerr << "Error: corrupted binary pattern header!!\n";
+      return false;
+   }
+   unsigned nRows = h.nPIs + h.nPOs, nWords = h.blockWords;
+   vector<size_t> rows(nRows * nWords);
+   string line(h.nPIs + (h.nPOs ? 1 + h.nPOs : 0), ' ');
+   for(uint64_t left = h.nPatterns; left != 0; ) {
+      if(!in.read((char*)&rows[0], rows.size() * sizeof(size_t))) {
+         cerr << "Error: binary pattern file is truncated!!\n";
+         return false;
+      }
+      unsigned n = (left < nWords * 64) ? left : nWords * 64;
+      for(unsigned k = 0; k < n; k++) {
+         unsigned w = k / 64, b = 63 - k % 64;
+         for(unsigned r = 0; r < nRows; r++) {
+            unsigned c = (r < h.nPIs) ? r : r + 1;
+            line[c] = '0' + ((rows[r * nWords + w] >> b) & 1);
+         }
+         out << line << '\n';
+      }
+      left -= n;
+   }
+   return true;
+}
+
+// The direction follows the format of "inFile"
+bool
+convertPatternFile(const string& inFile, const string& outFile)
+{
+   ifstream in(inFile.c_str(), ios::in | ios::binary);
+   if(!in) {
+      cerr << "Error: cannot open pattern file \"" << inFile << "\"!!\n";
+      return false;
+   }
+   char magic[8];
+   bool binary = in.read(magic, 8) && isBinaryPattern(magic, 8);
+   in.clear();
+   in.seekg(0);
+
+   ofstream out(outFile.c_str(), ios::out | ios::binary);
+   if(!out) {
+      cerr << "Error: cannot open pattern file \"" << outFile << "\"!!\n";
+      return false;
+   }
+   return binary ? binaryToText(in, out) : textToBinary(in, out);
+}
@@ -0,0 +1,52 @@
+/****************************************************************************
+  FileName     [ cirPattern.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define text/binary simulation pattern file helpers ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_PATTERN_H
+#define CIR_PATTERN_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// Binary pattern file: a PatternHeader followed by blocks of
+// (nPIs + nPOs) rows of blockWords 64-bit words each, PIs first. Pattern k
+// of a block is bit (63 - k % 64) of word (k / 64) of every row, i.e. the
+// layout of CirMgr's simulation buffer, so blocks are simulated in place.
+// The last block is zero-padded; words are stored in host (little-endian)
+// order. nPOs is 0 for pure input files.
+#define PATTERN_MAGIC       "FRAIGPAT"
+#define PATTERN_VERSION     1
+#define PATTERN_BLOCK_WORDS 64
+
+struct PatternHeader
+{
+   char     magic[8];
+   uint32_t version;
+   uint32_t nPIs;
+   uint32_t nPOs;
+   uint32_t blockWords;
+   uint64_t nPatterns;
+};
+
+// same white space as "ifstream >> string"
+inline bool
+isPatternSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+bool isBinaryPattern(const char* data, size_t size);
+bool readPatternHeader(const char* data, size_t size, PatternHeader& h);
+void initPatternHeader(PatternHeader& h, unsigned nPIs, unsigned nPOs,
+                       unsigned blockWords);
+
+bool checkPattern(const char* p, size_t len, size_t nPIs);
+void transposePatterns(const char* const* lines, unsigned n, unsigned nPIs,
+                       unsigned nWords, size_t* out);
+
+bool convertPatternFile(const string& inFile, const string& outFile);
+
+#endif // CIR_PATTERN_H
@@ -0,0 +1,567 @@
+/****************************************************************************
+  FileName     [ cirRewrite.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cut-based AIG rewriting ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <climits>
+#include <algorithm>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "cirRewrite.h"
+#include "util.h"
+
+using namespace std;
+
+/*******************************/
+/*   Global variable and enum  */
+/*******************************/
+// marks of RwState
+enum RwMark
+{
+   RW_NONE = 0,
+   RW_LEAF = 1,
+   RW_MFFC = 2,
+   RW_CONE = 3,   // visited, or referenced but not in the MFFC
+   RW_HIT  = 4    // leaf reached from the root
+};
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// gates visited to check that a cached cut still bounds the cone of a node
+#define RW_CONE_LIMIT 64
+// literal not in the netlist
+#define RW_NO_LIT     UINT_MAX
+
+static RwLib rwLib;
+
+static const unsigned varMask[4] = { 0xAAAA, 0xCCCC, 0xF0F0, 0xFF00 };
+
+// cofactors of "f" with variable v = 0 / 1 (functions that ignore v)
+static unsigned
+cofactor0(unsigned f, unsigned v)
+{
+   unsigned g = f & ~varMask[v];
+   return (g | (g << (1 << v))) & 0xFFFF;
+}
+
+static unsigned
+cofactor1(unsigned f, unsigned v)
+{
+   unsigned g = f & varMask[v];
+   return g | (g >> (1 << v));
+}
+
+static unsigned
+support(unsigned f)
+{
+   unsigned s = 0;
+   for(unsigned v = 0; v < 4; v++)
+      if(cofactor0(f, v) != cofactor1(f, v)) s |= 1 << v;
+   return s;
+}
+
+// exists over the variables of mask "vars"
+static unsigned
+exists(unsigned f, unsigned vars)
+{
+   for(unsigned v = 0; v < 4; v++)
+      if(vars & (1 << v)) f = cofactor0(f, v) | cofactor1(f, v);
+   return f;
+}
+
+// the variables of mask "vars" set to 0
+static unsigned
+restrict0(unsigned f, unsigned vars)
+{
+   for(unsigned v = 0; v < 4; v++)
+      if(vars & (1 << v)) f = cofactor0(f, v);
+   return f;
+}
+
+// truth table of "t" (over the leaves of "from") over the leaves of "to"
+static unsigned
+stretchTruth(unsigned t, const RwCut& from, const RwCut& to)
+{
+   if(from.nLeaves == to.nLeaves) return t;
+   unsigned pos[RW_CUT_SIZE];
+   for(unsigned i = 0, j = 0; i < from.nLeaves; i++, j++) {
+      while(to.leaves[j] != from.leaves[i]) j++;
+      pos[i] = j;
+   }
+   unsigned r = 0;
+   for(unsigned m = 0; m < 16; m++) {
+      unsigned s = 0;
+      for(unsigned i = 0; i < from.nLeaves; i++)
+         if((m >> pos[i]) & 1) s |= 1 << i;
+      if((t >> s) & 1) r |= 1 << m;
+   }
+   return r;
+}
+
+// sorted union of the leaves; false if it has more than RW_CUT_SIZE
+static bool
+mergeLeaves(const RwCut& a, const RwCut& b, RwCut& c)
+{
+   unsigned i = 0, j = 0, n = 0;
+   while(i < a.nLeaves || j < b.nLeaves) {
+      if(n == RW_CUT_SIZE) return false;
+      if(j == b.nLeaves || (i < a.nLeaves && a.leaves[i] < b.leaves[j]))
+         c.leaves[n++] = a.leaves[i++];
+      else if(i == a.nLeaves || b.leaves[j] < a.leaves[i])
+         c.leaves[n++] = b.leaves[j++];
+      else { c.leaves[n++] = a.leaves[i++]; j++; }
+   }
+   c.nLeaves = n;
+   return true;
+}
+
+// every leaf of "a" is one of "b"
+static bool
+subsumes(const RwCut& a, const RwCut& b)
+{
+   if(a.nLeaves > b.nLeaves) return false;
+   for(unsigned i = 0, j = 0; i < a.nLeaves; i++, j++) {
+      while(j < b.nLeaves && b.leaves[j] < a.leaves[i]) j++;
+      if(j == b.nLeaves || b.leaves[j] != a.leaves[i]) return false;
+   }
+   return true;
+}
+
+/***************************************/
+/*   class RwLib member functions      */
+/***************************************/
+// Classes are found by applying the 768 transforms to the smallest
+// function not classified yet; structures are then derived bottom-up
+void
+RwLib::build()
+{
+   unsigned char p[4] = { 0, 1, 2, 3 };
+   for(unsigned k = 0; k < 24; k++) {
+      for(unsigned i = 0; i < 4; i++) _perms[k][i] = p[i];
+      next_permutation(p, p + 4);
+   }
+
+   _canon.assign(1 << 16, 0);
+   _trans.assign(1 << 16, 0);
+   vector<bool> seen(1 << 16, false);
+   for(unsigned f = 0; f < (1 << 16); f++) {
+      if(seen[f]) continue;
+      for(unsigned t = 0; t < 24 * 32; t++) {
+         unsigned h = transform(f, t / 32, (t / 2) % 16, t % 2);
+         if(seen[h]) continue;
+         seen[h] = true;
+         _canon[h] = f;
+         _trans[h] = t;
+      }
+   }
+
+   _graphId.assign(1 << 16, -1);
+   _graphs.clear();
+   for(unsigned f = 0; f < (1 << 16); f++)
+      if(_canon[f] == f && _graphId[f] < 0) synthesize(f);
+}
+
+bool
+RwLib::mapInputs(unsigned f, const unsigned* varLits, unsigned* inLits) const
+{
+   unsigned t = _trans[f], p = t / 32, phase = (t / 2) % 16;
+   for(unsigned i = 0; i < 4; i++)
+      inLits[i] = varLits[_perms[p][i]] ^ ((phase >> i) & 1);
+   return t % 2;
+}
+
+// h(x) = outInv ^ f(y), where y_i = x_perm[i] ^ bit i of "phase"
+unsigned
+RwLib::transform(unsigned f, unsigned perm, unsigned phase, bool outInv) const
+{
+   unsigned h = 0;
+   for(unsigned x = 0; x < 16; x++) {
+      unsigned y = 0;
+      for(unsigned i = 0; i < 4; i++)
+         if(((x >> _perms[perm][i]) ^ (phase >> i)) & 1) y |= 1 << i;
+      if(((f >> y) & 1) != outInv) h |= 1 << x;
+   }
+   return h;
+}
+
+unsigned
+RwLib::cost(unsigned f)
+{
+   if(_graphId[_canon[f]] < 0) synthesize(_canon[f]);
+   return graph(f).size();
+}
+
+// Copies the structure of "f" into "dst", with "in" as the literals of the
+// variables of f; returns the literal of f
+unsigned
+RwLib::append(RwGraph& dst, unsigned f, const unsigned* in)
+{
+   cost(f);
+   const RwGraph& g = graph(f);
+   vector<unsigned> lits(5 + g.size(), 0);
+   bool outInv = mapInputs(f, in, &lits[1]);
+   for(unsigned j = 0; j < g.size(); j++)
+      lits[5 + j] = dst.addAnd(lits[g.fanin0[j] / 2] ^ (g.fanin0[j] & 1),
+                               lits[g.fanin1[j] / 2] ^ (g.fanin1[j] & 1));
+   return lits[g.out / 2] ^ (g.out & 1) ^ outInv;
+}
+
+// Tries, on every split of the support, c = g(A) AND/OR/XOR h(B), and on
+// every variable x the Shannon expansion (x & c1) | (!x & c0), which takes
+// one AND less if one cofactor implies the other; the cheapest wins
+void
+RwLib::synthesize(unsigned c)
+{
+   enum { SPLIT_AND, SPLIT_OR, SPLIT_XOR, SHANNON };
+   const unsigned in[4] = { 2, 4, 6, 8 };
+   RwGraph g;
+   unsigned s = support(c);
+   if(s == 0) g.out = c & 1;
+   else if((s & (s - 1)) == 0) {
+      unsigned v = 0;
+      while(!(s & (1 << v))) v++;
+      g.out = in[v] ^ (c != varMask[v]);
+   }
+   else {
+      unsigned best = UINT_MAX, kind = 0, f0 = 0, f1 = 0, var = 0;
+      unsigned low = s & (0u - s);
+      for(unsigned a = low; a < s; a += low) {
+         // split A = a, B = s \ a, with A holding the lowest variable
+         if((a & ~s) || !(a & low)) continue;
+         unsigned b = s & ~a;
+         unsigned g0 = exists(c, b), h0 = exists(c, a);
+         if((g0 & h0) == c && cost(g0) + cost(h0) + 1 < best) {
+            best = cost(g0) + cost(h0) + 1;
+            kind = SPLIT_AND; f0 = g0; f1 = h0;
+         }
+         unsigned nc = c ^ 0xFFFF;
+         g0 = exists(nc, b); h0 = exists(nc, a);
+         if((g0 & h0) == nc && cost(g0) + cost(h0) + 1 < best) {
+            best = cost(g0) + cost(h0) + 1;
+            kind = SPLIT_OR; f0 = g0; f1 = h0;
+         }
+         g0 = restrict0(c, b);
+         h0 = restrict0(c, a) ^ ((c & 1) ? 0xFFFF : 0);
+         if((g0 ^ h0) == c && cost(g0) + cost(h0) + 3 < best) {
+            best = cost(g0) + cost(h0) + 3;
+            kind = SPLIT_XOR; f0 = g0; f1 = h0;
+         }
+      }
+      for(unsigned v = 0; v < 4; v++) {
+         if(!(s & (1 << v))) continue;
+         unsigned c0 = cofactor0(c, v), c1 = cofactor1(c, v);
+         unsigned n = cost(c0) + cost(c1) +
+                      (((c0 & ~c1) == 0 || (c1 & ~c0) == 0) ? 2 : 3);
+         if(n < best) { best = n; kind = SHANNON; f0 = c0; f1 = c1; var = v; }
+      }
+
+      unsigned l0 = append(g, f0, in), l1 = append(g, f1, in);
+      if(kind == SPLIT_AND) g.out = g.addAnd(l0, l1);
+      else if(kind == SPLIT_OR) g.out = g.addAnd(l0, l1) ^ 1;
+      else if(kind == SPLIT_XOR)
+         g.out = g.addAnd(g.addAnd(l0, l1 ^ 1) ^ 1,
+                          g.addAnd(l0 ^ 1, l1) ^ 1) ^ 1;
+      else if((f0 & ~f1) == 0)   // c = c0 | (x & c1)
+         g.out = g.addAnd(l0 ^ 1, g.addAnd(in[var], l1) ^ 1) ^ 1;
+      else if((f1 & ~f0) == 0)   // c = c1 | (!x & c0)
+         g.out = g.addAnd(l1 ^ 1, g.addAnd(in[var] ^ 1, l0) ^ 1) ^ 1;
+      else
+         g.out = g.addAnd(g.addAnd(in[var], l1) ^ 1,
+                          g.addAnd(in[var] ^ 1, l0) ^ 1) ^ 1;
+      assert(g.size() == best && 2 * (5 + g.size()) <= 256);
+   }
+   _graphId[c] = _graphs.size();
+   _graphs.push_back(g);
+}
+
+/**************************************************/
+/*   Public member functions about optimization   */
+/**************************************************/
+// DAG-aware rewriting: every AIG, in topological order, is tried against
+// the library structure of each of its 4-input cuts. A structure costs the
+// ANDs it adds that the strash table cannot supply; it saves the MFFC of
+// the gate inside the cut (the gates only it uses). The best cut that
+// saves at least one AIG replaces the gate, and the freed MFFC is removed
+void
+CirMgr::rewrite()
+{
+   if(!rwLib.isBuilt()) rwLib.build();
+   if(!_strashed) strash();
+
+   RwState s;
+   s.cuts.resize(gateMap.size());
+   s.ref.assign(gateMap.size(), 0);
+   s.mark.assign(gateMap.size(), RW_NONE);
+   // the gates added meanwhile are only used as fanins
+   IdList order(_aig.aigList());
+   for(unsigned i = 0; i < order.size(); i++)
+      if(gateMap[order[i]] != 0) rewriteGate(order[i], s);
+
+   updateGateLists();
+   sortAllFanouts();
+   DFS();
+}
+
+/***************************************************/
+/*   Private member functions about optimization   */
+/***************************************************/
+void
+CirMgr::rewriteGate(unsigned id, RwState& s)
+{
+   s.cuts[id].clear();
+   computeCuts(id, s);
+   const RwCutSet& cuts = s.cuts[id];
+   unsigned best = 0, bestGain = 0;
+   for(unsigned i = 1; i < cuts.size(); i++) {   // 0: the trivial cut
+      if(!isCutOf(id, cuts[i], s)) continue;
+      unsigned mffc = derefMFFC(id, cuts[i], s);
+      unsigned added = countRewrite(id, cuts[i], mffc, s);
+      clearMarks(s);
+      if(mffc - added > bestGain) { bestGain = mffc - added; best = i; }
+   }
+   if(bestGain == 0) return;
+
+   RwCut cut = cuts[best];
+   unsigned lit = buildRewrite(cut, s);
+   CirGate* g = gateMap[id];
+   cout << "Rewriting: " << lit / 2 << " merging " << (lit & 1 ? "!" : "")
+        << id << "..." << endl;
+   replaceGate(g, size_t(gateMap[lit / 2]) ^ (lit & 1));
+   removeDangling(g);
+}
+
+// Cuts of "id" and of the fanins it needs first; the cuts of a node are
+// its trivial cut followed by the merges of the cuts of its fanins
+void
+CirMgr::computeCuts(unsigned id, RwState& s)
+{
+   IdList stack(1, id);
+   while(!stack.empty()) {
+      unsigned v = stack.back();
+      CirGate* g = gateMap[v];
+      if(!s.cuts[v].empty()) { stack.pop_back(); continue; }
+      unsigned a = g->getFaninLit(1) / 2, b = g->getFaninLit(2) / 2;
+      if(g->isAig() && s.cuts[a].empty()) { stack.push_back(a); continue; }
+      if(g->isAig() && s.cuts[b].empty()) { stack.push_back(b); continue; }
+      stack.pop_back();
+
+      RwCutSet& cuts = s.cuts[v];
+      RwCut trivial;
+      trivial.nLeaves = 1;
+      trivial.leaves[0] = v;
+      trivial.truth = varMask[0];
+      cuts.push_back(trivial);
+      if(!g->isAig()) continue;
+
+      unsigned invA = (g->getFaninLit(1) & 1) ? 0xFFFF : 0;
+      unsigned invB = (g->getFaninLit(2) & 1) ? 0xFFFF : 0;
+      const RwCutSet& cutsA = s.cuts[a];
+      const RwCutSet& cutsB = s.cuts[b];
+      for(unsigned i = 0; i < cutsA.size(); i++) {
+         for(unsigned j = 0; j < cutsB.size(); j++) {
+            if(cuts.size() == RW_MAX_CUTS) break;
+            RwCut c;
+            if(!mergeLeaves(cutsA[i], cutsB[j], c)) continue;
+            bool dominated = false;
+            for(unsigned k = 1; k < cuts.size() && !dominated; k++)
+               dominated = subsumes(cuts[k], c);
+            if(dominated) continue;
+            for(unsigned k = 1; k < cuts.size(); )
+               if(subsumes(c, cuts[k])) {
+                  cuts[k] = cuts.back();
+                  cuts.pop_back();
+               }
+               else k++;
+            c.truth = (stretchTruth(cutsA[i].truth ^ invA, cutsA[i], c) &
+                       stretchTruth(cutsB[j].truth ^ invB, cutsB[j], c));
+            cuts.push_back(c);
+         }
+      }
+   }
+}
+
+// Cuts of the fanins may have been computed before some of the gates below
+// were rewritten. Their truth tables still hold, since every rewrite keeps
+// the function of every gate, but the leaves may no longer bound the cone;
+// such a cut is dropped, so no leaf can be a fanout of "id"
+bool
+CirMgr::isCutOf(unsigned id, const RwCut& cut, RwState& s)
+{
+   for(unsigned i = 0; i < cut.nLeaves; i++) {
+      s.mark[cut.leaves[i]] = RW_LEAF;
+      s.touched.push_back(cut.leaves[i]);
+   }
+   unsigned reached = 0;
+   bool ok = true;
+   IdList stack(1, id);
+   s.mark[id] = RW_CONE;
+   s.touched.push_back(id);
+   while(ok && !stack.empty()) {
+      CirGate* g = gateMap[stack.back()];
+      stack.pop_back();
+      for(unsigned i = 0; i < 2 && ok; i++) {
+         CirGate* f = CirGate::unmask(g->getFanin(i));
+         unsigned v = f->getID();
+         if(s.mark[v] == RW_LEAF) { s.mark[v] = RW_HIT; reached++; }
+         if(s.mark[v] != RW_NONE) continue;
+         if(!f->isAig() || s.touched.size() > RW_CONE_LIMIT) ok = false;
+         s.mark[v] = RW_CONE;
+         s.touched.push_back(v);
+         stack.push_back(v);
+      }
+   }
+   clearMarks(s);
+   return ok && reached == cut.nLeaves;
+}
+
+// Marks the leaves and the MFFC of "id" inside the cut, and returns the
+// size of the MFFC
+unsigned
+CirMgr::derefMFFC(unsigned id, const RwCut& cut, RwState& s)
+{
+   for(unsigned i = 0; i < cut.nLeaves; i++) {
+      s.mark[cut.leaves[i]] = RW_LEAF;
+      s.touched.push_back(cut.leaves[i]);
+   }
+   unsigned n = 1;
+   IdList stack(1, id);
+   s.mark[id] = RW_MFFC;
+   s.touched.push_back(id);
+   while(!stack.empty()) {
+      CirGate* g = gateMap[stack.back()];
+      stack.pop_back();
+      for(unsigned i = 0; i < 2; i++) {
+         CirGate* f = CirGate::unmask(g->getFanin(i));
+         unsigned v = f->getID();
+         if(!f->isAig() || s.mark[v] == RW_LEAF) continue;
+         if(s.mark[v] == RW_NONE) {
+            s.mark[v] = RW_CONE;
+            s.ref[v] = f->getFanouts().size();
+            s.touched.push_back(v);
+         }
+         if(--s.ref[v] == 0) {
+            s.mark[v] = RW_MFFC;
+            stack.push_back(v);
+            n++;
+         }
+      }
+   }
+   return n;
+}
+
+void
+CirMgr::clearMarks(RwState& s)
+{
+   for(unsigned i = 0; i < s.touched.size(); i++)
+      s.mark[s.touched[i]] = RW_NONE;
+   s.touched.clear();
+}
+
+// AIGs the structure of the cut adds: those the strash table does not
+// have, and those it has in the dereferenced MFFC (they are kept then).
+// Returns "limit" as soon as it is reached, or if the structure goes
+// through "id" itself
+unsigned
+CirMgr::countRewrite(unsigned id, const RwCut& cut, unsigned limit,
+                     RwState& s)
+{
+   const RwGraph& g = rwLib.graph(cut.truth);
+   unsigned varLits[4] = { 0, 0, 0, 0 };
+   for(unsigned i = 0; i < cut.nLeaves; i++) varLits[i] = 2 * cut.leaves[i];
+   vector<unsigned> lits(5 + g.size(), 0);
+   rwLib.mapInputs(cut.truth, varLits, &lits[1]);
+
+   unsigned added = 0;
+   for(unsigned j = 0; j < g.size(); j++) {
+      unsigned a = lits[g.fanin0[j] / 2], b = lits[g.fanin1[j] / 2];
+      unsigned lit = RW_NO_LIT;
+      if(a != RW_NO_LIT && b != RW_NO_LIT)
+         lit = lookupAnd(a ^ (g.fanin0[j] & 1), b ^ (g.fanin1[j] & 1));
+      if(lit != RW_NO_LIT && lit / 2 == id) return limit;
+      if(lit == RW_NO_LIT || s.mark[lit / 2] == RW_MFFC)
+         if(++added >= limit) return limit;
+      lits[5 + j] = lit;
+   }
+   unsigned out = lits[g.out / 2];
+   if(out != RW_NO_LIT && out / 2 == id) return limit;
+   return added;
+}
+
+// Instantiates the structure of the cut; returns the literal of its output
+unsigned
+CirMgr::buildRewrite(const RwCut& cut, RwState& s)
+{
+   const RwGraph& g = rwLib.graph(cut.truth);
+   unsigned varLits[4] = { 0, 0, 0, 0 };
+   for(unsigned i = 0; i < cut.nLeaves; i++) varLits[i] = 2 * cut.leaves[i];
+   vector<unsigned> lits(5 + g.size(), 0);
+   bool outInv = rwLib.mapInputs(cut.truth, varLits, &lits[1]);
+
+   for(unsigned j = 0; j < g.size(); j++) {
+      unsigned a = lits[g.fanin0[j] / 2] ^ (g.fanin0[j] & 1);
+      unsigned b = lits[g.fanin1[j] / 2] ^ (g.fanin1[j] & 1);
+      lits[5 + j] = lookupAnd(a, b);
+      if(lits[5 + j] == RW_NO_LIT) lits[5 + j] = 2 * newAig(a, b);
+   }
+   s.cuts.resize(gateMap.size());
+   s.ref.resize(gateMap.size(), 0);
+   s.mark.resize(gateMap.size(), RW_NONE);
+   return lits[g.out / 2] ^ (g.out & 1) ^ outInv;
+}
+
+// Literal of AND(a, b) if it is trivial or in the strash table
+unsigned
+CirMgr::lookupAnd(unsigned a, unsigned b) const
+{
+   if(a == 0 || b == 0 || a == (b ^ 1)) return 0;
+   if(a == 1 || a == b) return b;
+   if(b == 1) return a;
+   unsigned id = _strashTable.find(a, b);
+   return id == UINT32_MAX ? RW_NO_LIT : 2 * id;
+}
+
+// New AIG, numbered after every gate (the POs included)
+unsigned
+CirMgr::newAig(unsigned a, unsigned b)
+{
+   unsigned id = gateMap.size();
+   CirGate* g = new AIGGate(id, 0);
+   CirGate* fin1 = gateMap[a / 2];
+   CirGate* fin2 = gateMap[b / 2];
+   g->setFanin(fin1, a & 1, 1);
+   fin1->setFanout(g, a & 1);
+   g->setFanin(fin2, b & 1, 2);
+   fin2->setFanout(g, b & 1);
+   gateMap.push_back(g);
+   AIGs.push_back(g);
+   _aig.addAig(id, a, b);
+   _mergedInto.push_back(0);
+   _strashTable.insert(a, b, id);
+   return id;
+}
+
+// Removes the fanins of the replaced "gate" that are left without
+// fanouts, and theirs in turn
+void
+CirMgr::removeDangling(CirGate* gate)
+{
+   GateList stack;
+   stack.push_back(CirGate::unmask(gate->getFanin(0)));
+   stack.push_back(CirGate::unmask(gate->getFanin(1)));
+   while(!stack.empty()) {
+      CirGate* g = stack.back();
+      stack.pop_back();
+      if(!g->isAig() || gateMap[g->getID()] == 0 || !g->definedNotUsed())
+         continue;
+      unhash(g);
+      g->rmRelatingFanouts();
+      gateMap[g->getID()] = 0;
+      stack.push_back(CirGate::unmask(g->getFanin(0)));
+      stack.push_back(CirGate::unmask(g->getFanin(1)));
+   }
+}
@@ -0,0 +1,93 @@
+/****************************************************************************
+  FileName     [ cirRewrite.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the cuts and the NPN structure library of rewriting ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_REWRITE_H
+#define CIR_REWRITE_H
+
+#include <vector>
+#include "cirDef.h"
+
+using namespace std;
+
+// leaves of the largest cut rewritten, and cuts kept per node
+#define RW_CUT_SIZE  4
+#define RW_MAX_CUTS  8
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Cut of an AIG node: sorted leaf IDs, and the truth table of the node
+// with leaf i as variable i (bit m is the value on minterm m)
+struct RwCut
+{
+   unsigned       nLeaves;
+   unsigned       leaves[RW_CUT_SIZE];
+   unsigned short truth;
+};
+
+typedef vector<RwCut> RwCutSet;
+
+// Scratch of CirMgr::rewrite(), indexed by gate ID
+struct RwState
+{
+   vector<RwCutSet>  cuts;       // empty: not computed yet
+   IdList            ref;        // fanouts left while an MFFC is dereferenced
+   vector<char>      mark;       // 1: cut leaf; 2: in the dereferenced MFFC
+   IdList            touched;
+};
+
+// AIG over 4 inputs; literals are 2 * v + inv, where v = 0 is constant 0,
+// v = 1..4 the inputs and v = 5 + j node j (fanins before fanouts)
+struct RwGraph
+{
+   vector<unsigned char> fanin0;
+   vector<unsigned char> fanin1;
+   unsigned char         out;
+
+   unsigned size() const { return fanin0.size(); }
+   unsigned addAnd(unsigned a, unsigned b) {
+      fanin0.push_back(a); fanin1.push_back(b);
+      return 2 * (4 + fanin0.size());
+   }
+};
+
+// The 2^16 functions of 4 variables fall into 222 NPN classes (equal up to
+// permuting and complementing the inputs, and complementing the output).
+// One structure is derived per class when the library is built, as the
+// cheapest of its AND, OR, XOR and Shannon decompositions into smaller
+// classes; every function of a class shares it
+class RwLib
+{
+public:
+   RwLib() {}
+   ~RwLib() {}
+
+   void build();
+   bool isBuilt() const { return !_canon.empty(); }
+
+   const RwGraph& graph(unsigned f) const {
+      return _graphs[_graphId[_canon[f]]];
+   }
+   // literals of the inputs of graph(f), from those of the variables of f;
+   // returns true if the output of graph(f) is to be complemented
+   bool mapInputs(unsigned f, const unsigned* varLits, unsigned* inLits) const;
+
+private:
+   vector<unsigned short>  _canon;     // smallest function of the class
+   vector<unsigned short>  _trans;     // perm * 32 + input phase * 2 + out
+   vector<short>           _graphId;   // of the canonical functions
+   vector<RwGraph>         _graphs;
+   unsigned char           _perms[24][4];
+
+   unsigned transform(unsigned, unsigned, unsigned, bool) const;
+   unsigned cost(unsigned);
+   unsigned append(RwGraph&, unsigned, const unsigned*);
+   void synthesize(unsigned);
+};
+
+#endif // CIR_REWRITE_H
@@ -15,8 +15,19 @@
 #include <string>
 #include <limits>
 #include <queue>
+#include <thread>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #include "cirMgr.h"
 #include "cirGate.h"
+#include "cirPattern.h"
 #include "util.h"
 
 using namespace std;
@@ -31,6 +42,70 @@ using namespace std;
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+// out[i] = (a[i] ^ ma) & (b[i] ^ mb); ma/mb are all-0 or all-1 masks
+typedef void (*SimAndKernel)(size_t*, const size_t*, size_t,
+                             const size_t*, size_t, unsigned);
+
+static void
+simAndScalar(size_t* out, const size_t* a, size_t ma,
+             const size_t* b, size_t mb, unsigned n)
+{
+   for(unsigned i = 0; i < n; i++)
+      out[i] = (a[i] ^ ma) & (b[i] ^ mb);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) static void
+simAndAVX2(size_t* out, const size_t* a, size_t ma,
+           const size_t* b, size_t mb, unsigned n)
+{
+   __m256i va = _mm256_set1_epi64x(ma);
+   __m256i vb = _mm256_set1_epi64x(mb);
+   unsigned i = 0;
+   for(; i + 4 <= n; i += 4) {
+      __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+      __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+      x = _mm256_and_si256(_mm256_xor_si256(x, va), _mm256_xor_si256(y, vb));
+      _mm256_storeu_si256((__m256i*)(out + i), x);
+   }
+   for(; i < n; i++)
+      out[i] = (a[i] ^ ma) & (b[i] ^ mb);
+}
+
+__attribute__((target("avx512f"))) static void
+simAndAVX512(size_t* out, const size_t* a, size_t ma,
+             const size_t* b, size_t mb, unsigned n)
+{
+   __m512i va = _mm512_set1_epi64(ma);
+   __m512i vb = _mm512_set1_epi64(mb);
+   unsigned i = 0;
+   for(; i + 8 <= n; i += 8) {
+      __m512i x = _mm512_loadu_si512((const void*)(a + i));
+      __m512i y = _mm512_loadu_si512((const void*)(b + i));
+      x = _mm512_and_si512(_mm512_xor_si512(x, va), _mm512_xor_si512(y, vb));
+      _mm512_storeu_si512((void*)(out + i), x);
+   }
+   for(; i < n; i++)
+      out[i] = (a[i] ^ ma) & (b[i] ^ mb);
+}
+#endif
+
+// pick the widest kernel the running CPU supports
+static SimAndKernel
+selectSimKernel()
+{
+#if defined(__x86_64__)
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("avx512f")) return simAndAVX512;
+   if(__builtin_cpu_supports("avx2"))    return simAndAVX2;
+#endif
+   return simAndScalar;
+}
+
+static SimAndKernel simAndWide = selectSimKernel();
+
+static inline size_t
+invMask(unsigned lit) { return (lit & 1) ? ~size_t(0) : 0; }
 
 /************************************************/
 /*   Public member functions about Simulation   */
@@ -40,30 +115,31 @@ CirMgr::randomSim()
 {
    unsigned patternNumber = 0;
 
-   bool _quit = false;
-   while(!_quit) {
-      vector<SimValue> patterns;
-      patterns.resize(PIs.size());
+   unsigned intbits = sizeof(int) * 8;
+   unsigned sztbits = sizeof(size_t) * 8;
 
-      unsigned intbits = sizeof(int) * 8;
-      unsigned sztbits = sizeof(size_t) * 8;
+   // _simWidth words of patterns per PI are simulated in each pass
+   vector<size_t> patterns;
+   patterns.resize(PIs.size() * _simWidth);
 
-      for(unsigned i = 0; i < PIs.size(); i++) {
+   bool _quit = false;
+   while(!_quit) {
+      for(unsigned i = 0; i < patterns.size(); i++) {
+         patterns[i] = 0;
          for(unsigned j = 0; j < sztbits; j += intbits) {
             patterns[i] <<= intbits;
             patterns[i] += rnGen(INT_MAX);
          }
       }
-      patternNumber += sztbits;
+      patternNumber += sztbits * _simWidth;
       
-      simulateAll(patterns);
+      simulateAll(patterns.data(), _simWidth);
       cout << '\r';
       identifyFECs();
-      sortFECGrps();
 
       if(randomCheckPoint()) _quit = true;
 
-      writeSimulationLog(patternNumber);
+      writeSimulationLog(sztbits * _simWidth);
 
       simulated = true;
    }
@@ -71,91 +147,140 @@ CirMgr::randomSim()
    cout << "\r" << patternNumber << " patterns simulated." << endl;
    sortFECGrps();
 
-   _simLog = 0;
+   closeSimulationLog();
 }
 
+// The pattern file is memory-mapped and scanned in place; pages behind the
+// cursor are released after every block, so files larger than RAM stream
 void
-CirMgr::fileSim(ifstream& patternFile)
+CirMgr::fileSim(const string& fileName)
 {
-   string buf;
+   int fd = open(fileName.c_str(), O_RDONLY);
+   struct stat st;
+   if(fd < 0 || fstat(fd, &st) != 0) {
+      cerr << "Error: cannot open pattern file \"" << fileName << "\"!!\n";
+      if(fd >= 0) close(fd);
+      return;
+   }
+   size_t fileSize = st.st_size;
+   char* base = 0;
+   if(fileSize != 0) {
+      base = (char*)mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(base == MAP_FAILED) {
+         cerr << "Error: cannot map pattern file \"" << fileName << "\"!!\n";
+         close(fd);
+         return;
+      }
+      madvise(base, fileSize, MADV_SEQUENTIAL);
+   }
+   close(fd);
+
+   const char *cur = base, *end = base + fileSize;
+   size_t pageMask = size_t(sysconf(_SC_PAGESIZE)) - 1, released = 0;
+
+   // a binary file is simulated straight from the mapping
+   PatternHeader h;
+   bool binary = isBinaryPattern(base, fileSize);
+   if(binary) {
+      if(!readPatternHeader(base, fileSize, h)) {
+         cerr << "\nError: Pattern file \"" << fileName
+              << "\" has a corrupted header!!\n";
+         cur = end;
+      }
+      else if(h.nPIs != PIs.size()) {
+         cerr << "\nError: Pattern file inputs(" << h.nPIs
+              << ") does not match the number of inputs("
+              << PIs.size() << ") in a circuit!!\n";
+         cur = end;
+      }
+      else cur += sizeof(PatternHeader);
+   }
+   uint64_t binLeft = binary ? h.nPatterns : 0;
+   size_t binBlock = binary ? size_t(h.nPIs + h.nPOs) * h.blockWords : 0;
+
+   unsigned nWords = binary ? h.blockWords : _simWidth;
+   unsigned blockSize = nWords * sizeof(size_t) * 8;
+   vector<size_t> patterns(binary ? 0 : PIs.size() * nWords);
+   vector<const char*> lines(binary ? 0 : blockSize);
    unsigned patternNumber = 0;
 
-   while(true) {
-      // read pattern files
-      bool _quit = false;
-      vector<SimValue> patterns;
-      patterns.resize(PIs.size());
-      for(unsigned i = 0; i < sizeof(void*) * 8; i++) {
-         patternFile >> buf;
-         if(!patternFile) {
-            for(unsigned j = 0; j < buf.size(); j++) 
-               patterns[j] <<=1;
-            if(i == 0) _quit = true;
-            else continue;
-         }
-         if(buf.size() != PIs.size()) {
-            cerr << "\nError: Pattern(" << buf
-                 << ") length(" << buf.size()
-                 << ") does not match the number of inputs("
-                 << PIs.size() << ") in a circuit!!\n";
-            patternNumber -= i;
-            _quit = true;
+   bool _quit = false;
+   while(!_quit) {
+      const size_t* block = patterns.data();
+      unsigned n = 0;
+      if(binary) {
+         if(cur == end || binLeft == 0) break;
+         if(size_t(end - cur) < binBlock * sizeof(size_t)) {
+            cerr << "\nError: Pattern file \"" << fileName
+                 << "\" is truncated!!\n";
+            break;
          }
-         for(unsigned j = 0; j < buf.size(); j++) {
-            if(buf[j] == '0')
-               patterns[j] <<=1;
-            else if(buf[j] == '1') {
-               patterns[j] <<=1;
-               patterns[j] += 1;
-            }
-            else {
-               cerr << "\nError: Pattern(" << buf
-                    << ") contains a non-0/1 character(\'"
-                    << buf[j] << "\').\n";
-               patternNumber -= i;
-               _quit = true;
+         block = (const size_t*)cur;
+         n = (binLeft < blockSize) ? binLeft : blockSize;
+         binLeft -= n;
+         cur += binBlock * sizeof(size_t);
+      }
+      else {
+         // collect up to blockSize pattern lines; a bad line drops the block
+         for(; n < blockSize; n++) {
+            while(cur != end && isPatternSpace(*cur)) cur++;
+            if(cur == end) { _quit = true; break; }
+            const char* tok = cur;
+            while(cur != end && !isPatternSpace(*cur)) cur++;
+            if(!checkPattern(tok, cur - tok, PIs.size())) {
+               n = 0; _quit = true; break;
             }
+            lines[n] = tok;
          }
-
-         if(_quit) break;
-         patternNumber++;
+         if(n == 0) break;
+         fill(patterns.begin(), patterns.end(), 0);
+         transposePatterns(&lines[0], n, PIs.size(), nWords, &patterns[0]);
       }
+      patternNumber += n;
 
-      if(_quit) break;
-      simulateAll(patterns);
+      simulateAll(block, nWords);
+      _simLastWord = (n - 1) / (sizeof(size_t) * 8);
       cout << '\r';
       identifyFECs();
 
-      writeSimulationLog(patternNumber);
+      writeSimulationLog(n);
 
       simulated = true;
+
+      size_t done = (cur - base) & ~pageMask;
+      if(done > released) {
+         madvise(base + released, done - released, MADV_DONTNEED);
+         released = done;
+      }
    }
+   if(base != 0) munmap(base, fileSize);
 
    cout << "\r" << patternNumber << " patterns simulated." << endl;
    sortFECGrps();
-   _simLog = 0;
+   closeSimulationLog();
 }
 
 /*************************************************/
 /*   Private member functions about Simulation   */
 /*************************************************/
-void
-AIGGate::simulate(SimValue)
-{
-   SimValue val1 = unmask(fanin1)->getSimValue();
-   SimValue val2 = unmask(fanin2)->getSimValue();
-   val1 = val1 ^ isInverting(fanin1);
-   val2 = val2 ^ isInverting(fanin2);
-   //if(isInverting(fanin1)) val1 = ~val1;
-   //if(isInverting(fanin2)) val2 = ~val2;
-   setSimValue(val1 & val2, false);
-}
-
+// Restores the order printFECPairs() and the group leaders rely on: the
+// slots emptied by deleteFromFECGrp() are dropped, members are sorted by ID
+// (refining keeps them so; only deletions reorder them) and groups by their
+// first member
 void
 CirMgr::sortFECGrps()
 {
+   unsigned n = 0;
    for(unsigned i = 0; i < fecGrps.size(); i++)
-      sort(fecGrps[i]->begin(), fecGrps[i]->end(), CirGate::compareByID);
+      if(fecGrps[i] != 0) fecGrps[n++] = fecGrps[i];
+   fecGrps.resize(n);
+
+   for(unsigned i = 0; i < fecGrps.size(); i++) {
+      FECGroup& grp = *fecGrps[i];
+      if(!is_sorted(grp.begin(), grp.end(), CirGate::compareByID))
+         sort(grp.begin(), grp.end(), CirGate::compareByID);
+   }
+
    struct {
       bool operator () (FECGroup* i, FECGroup* j) const {
          return CirGate::unmask((*i)[0])->getID() < CirGate::unmask((*j)[0])->getID();
@@ -163,13 +288,20 @@ CirMgr::sortFECGrps()
    } compare;
    sort(fecGrps.begin(), fecGrps.end(), compare);
 
-   // generate fecGrpMap
-   fecGrpMap.clear();
-   fecGrpMap.resize(gateMap.size());
-   for(unsigned i = 0; i < fecGrps.size(); i++) {
-      for(unsigned j = 0; j < fecGrps[i]->size(); j++) {
-         fecGrpMap[CirGate::unmask((*fecGrps[i])[j])->getID()] = i + 1;
-      }
+   for(unsigned i = 0; i < fecGrps.size(); i++)
+      mapFECGrp(i);
+}
+
+// Point fecGrpMap and fecGrpPos of the members of fecGrps[i], from
+// position "from" on, at the group
+void
+CirMgr::mapFECGrp(unsigned i, unsigned from)
+{
+   const FECGroup& grp = *fecGrps[i];
+   for(unsigned j = from; j < grp.size(); j++) {
+      unsigned id = CirGate::unmask(grp[j])->getID();
+      fecGrpMap[id] = i + 1;
+      fecGrpPos[id] = j;
    }
 }
 
@@ -182,75 +314,198 @@ CirMgr::resetFECGrps()
       }
    }
    fecGrps.clear();
+   fecGrpMap.assign(gateMap.size(), 0);
+   fecGrpPos.assign(gateMap.size(), 0);
 
    FECGroup* fecGrp = new FECGroup;
 
+   const IdList& aigs = _aig.aigList();
    fecGrp->push_back(size_t(constGate));
-   for(unsigned i = 0; i < _dfsList.size(); i++) {
-      if(_dfsList[i]->getTypeStr() != "AIG") continue;
-      fecGrp->push_back(size_t(_dfsList[i]));
-   }
+   for(unsigned i = 0; i < aigs.size(); i++)
+      fecGrp->push_back(size_t(gateMap[aigs[i]]));
+   sort(fecGrp->begin(), fecGrp->end(), CirGate::compareByID);
 
    fecGrps.push_back(fecGrp);
+   mapFECGrp(0);
 }
 
 void
 CirMgr::simulateAll(const vector<SimValue>& patterns)
 {
-   constGate->simulate();
+   vector<size_t> words(patterns.size());
+   for(unsigned i = 0; i < patterns.size(); i++)
+      words[i] = patterns[i]._value;
+   simulateAll(words.data(), 1);
+}
+
+// patterns[i * nWords .. (i+1) * nWords) are the patterns of PIs[i]
+void
+CirMgr::simulateAll(const size_t* patterns, unsigned nWords)
+{
+   if(_simWords != nWords || _simData.size() != gateMap.size() * nWords) {
+      _simWords = nWords;
+      _simData.assign(gateMap.size() * nWords, 0);
+   }
+   _simLastWord = nWords - 1;
+
+   unsigned nThreads = _simThreads < nWords ? _simThreads : nWords;
+   if(nThreads <= 1) {
+      simulateWords(patterns, 0, nWords);
+      return;
+   }
+   // Every worker owns a column block of words for all gates. Blocks are
+   // rounded up to 8 words (a cache line), which confines false sharing to
+   // the lines at block boundaries; rows are not padded, so those are only
+   // line-aligned if nWords is a multiple of 8
+   unsigned block = ((nWords + nThreads - 1) / nThreads + 7) & ~7u;
+   vector<thread> workers;
+   for(unsigned w = block; w < nWords; w += block) {
+      unsigned e = (w + block < nWords) ? w + block : nWords;
+      workers.push_back(thread(&CirMgr::simulateWords, this,
+                               patterns, w, e));
+   }
+   simulateWords(patterns, 0, block < nWords ? block : nWords);
+   for(unsigned i = 0; i < workers.size(); i++)
+      workers[i].join();
+}
+
+// simulate pattern words [begin, end) of every gate; the netlist is only read
+void
+CirMgr::simulateWords(const size_t* patterns, unsigned begin, unsigned end)
+{
+   unsigned nWords = _simWords, n = end - begin;
+   SimAndKernel simAnd = (n < 4) ? simAndScalar : simAndWide;
+   size_t* data = &_simData[begin];
+
    for(unsigned i = 0; i < PIs.size(); i++) {
-      PIs[i]->simulate(patterns[i]);
+      copy(patterns + i * nWords + begin, patterns + i * nWords + end,
+           data + PIs[i]->getID() * nWords);
+   }
+   const IdList& aigs = _aig.aigList();
+   for(unsigned i = 0; i < aigs.size(); i++) {
+      unsigned a = _aig.fanin0(aigs[i]);
+      unsigned b = _aig.fanin1(aigs[i]);
+      simAnd(data + aigs[i] * nWords,
+             data + CirAig::var(a) * nWords, invMask(a),
+             data + CirAig::var(b) * nWords, invMask(b), n);
    }
-   for(unsigned i = 0; i < _dfsList.size(); i++) {
-      if(_dfsList[i]->getTypeStr() == "PI") continue;
-      else _dfsList[i]->simulate();
+   const IdList& pos = _aig.poList();
+   for(unsigned i = 0; i < pos.size(); i++) {
+      unsigned a = _aig.fanin0(pos[i]);
+      const size_t* in = data + CirAig::var(a) * nWords;
+      simAnd(data + pos[i] * nWords, in, invMask(a), in, invMask(a), n);
    }
 }
 
+const size_t*
+CirMgr::getSimRow(size_t gate) const
+{
+   return &_simData[CirGate::unmask(gate)->getID() * _simWords];
+}
+
+// Refine every FEC group by the current simulation values. Only groups that
+// split are rewritten; groups left with a single member are removed and the
+// holes are filled from the back, so fecGrps is not ordered afterwards
 void
 CirMgr::identifyFECs()
 {
    if(!simulated) resetFECGrps();
 
-   vector<FECGroup*> tmpFecGrps;
-   for(unsigned i = 0; i < fecGrps.size(); i++) {
-      HashMap<SimValue, FECGroup*> newFecGrps(fecGrps[i]->size());
-      for(unsigned j = 0; j < fecGrps[i]->size(); j++) {
-         size_t gate = (*fecGrps[i])[j];
-         
-         if(gate == 0) continue;
-
-         FECGroup* grp;
-         SimValue val = CirGate::unmask(gate)->getSimValue() ^ CirGate::isInverting(gate);
-          
-         if(newFecGrps.query(val, grp)) {
-            grp->push_back(gate);
-            newFecGrps.update(val, grp);
-         }
-         else if(newFecGrps.query(val ^ true, grp)) {
-            grp->push_back(gate ^= 0x1);
-            newFecGrps.update(val ^ true, grp);
-         }
-         else {
-            grp = new FECGroup;
-            grp->push_back(gate);
-            newFecGrps.insert(val, grp);
-         }
-      }
-      HashMap<SimValue, FECGroup*>::iterator it = newFecGrps.begin();
-      for(; it != newFecGrps.end(); ++it) {
-         if((*it).second->size() > 1)
-            tmpFecGrps.push_back((*it).second);
-         else delete (*it).second;
-      }
-      delete fecGrps[i];
+   // slots emptied by deleteFromFECGrp() are compacted with the others
+   unsigned nGrps = fecGrps.size();
+   for(unsigned i = 0; i < nGrps; i++)
+      if(fecGrps[i] != 0) refineFECGrp(i);
+
+   for(unsigned i = 0; i < fecGrps.size(); ) {
+      if(fecGrps[i] != 0) { i++; continue; }
+      fecGrps[i] = fecGrps.back();
+      fecGrps.pop_back();
+      if(i < fecGrps.size() && fecGrps[i] != 0) mapFECGrp(i);
    }
-   fecGrps.clear();
-   fecGrps = tmpFecGrps;
    cout << "Total #FEC Group = " << fecGrps.size();
    cout.flush();
 }
 
+// Members are phase-normalized: a gate is stored inverted iff bit 0 of its
+// first simulation word is 1, so FEC members have identical normalized rows.
+// A group that does not split is only renormalized. A group that splits is
+// stable-sorted by normalized row (keeping the order of its members inside
+// each run); the run holding the old first member stays in place at index
+// i, the other runs become new groups at the back
+void
+CirMgr::refineFECGrp(unsigned i)
+{
+   FECGroup& grp = *fecGrps[i];
+   unsigned nWords = _simWords;
+
+   const size_t* row0 = 0;
+   size_t mask0 = 0;
+   bool split = false;
+   for(unsigned j = 0; j < grp.size() && !split; j++) {
+      if(grp[j] == 0) { split = true; break; }
+      const size_t* row = getSimRow(grp[j]);
+      size_t mask = invMask(row[0] & 1);
+      if(row0 == 0) { row0 = row; mask0 = mask; continue; }
+      for(unsigned k = 0; k < nWords; k++)
+         if((row[k] ^ mask) != (row0[k] ^ mask0)) { split = true; break; }
+   }
+   if(!split) {
+      // the group as built by resetFECGrps() holds no phases yet
+      for(unsigned j = 0; j < grp.size(); j++)
+         grp[j] = (grp[j] & ~size_t(1)) | (getSimRow(grp[j])[0] & 1);
+      return;
+   }
+
+   // drop deleted members and normalize phases
+   unsigned n = 0;
+   for(unsigned j = 0; j < grp.size(); j++) {
+      if(grp[j] == 0) continue;
+      size_t gate = grp[j] & ~size_t(1);
+      grp[n++] = gate | (getSimRow(gate)[0] & 1);
+   }
+   grp.resize(n);
+   if(n == 0) { delete &grp; fecGrps[i] = 0; return; }
+   size_t first = grp[0];
+
+   const vector<size_t>& data = _simData;
+   struct {
+      const size_t* data; unsigned nWords;
+      bool operator () (size_t a, size_t b) const {
+         const size_t* ra = data + CirGate::unmask(a)->getID() * nWords;
+         const size_t* rb = data + CirGate::unmask(b)->getID() * nWords;
+         size_t ma = invMask(a & 1), mb = invMask(b & 1);
+         for(unsigned k = 0; k < nWords; k++)
+            if((ra[k] ^ ma) != (rb[k] ^ mb)) return (ra[k] ^ ma) < (rb[k] ^ mb);
+         return false;
+      }
+   } sigLess = { &data[0], nWords };
+   stable_sort(grp.begin(), grp.end(), sigLess);
+
+   unsigned keepBegin = 0, keepEnd = 0;
+   for(unsigned b = 0, e; b < n; b = e) {
+      for(e = b + 1; e < n && !sigLess(grp[b], grp[e]); e++) ;
+      bool keep = false;
+      for(unsigned j = b; j < e && !keep; j++)
+         if(grp[j] == first) keep = true;
+      if(keep) { keepBegin = b; keepEnd = e; continue; }
+      if(e - b == 1) {
+         fecGrpMap[CirGate::unmask(grp[b])->getID()] = 0;
+         continue;
+      }
+      fecGrps.push_back(new FECGroup(grp.begin() + b, grp.begin() + e));
+      mapFECGrp(fecGrps.size() - 1);
+   }
+   if(keepEnd - keepBegin == 1) {
+      fecGrpMap[CirGate::unmask(first)->getID()] = 0;
+      delete &grp;
+      fecGrps[i] = 0;
+      return;
+   }
+   copy(grp.begin() + keepBegin, grp.begin() + keepEnd, grp.begin());
+   grp.resize(keepEnd - keepBegin);
+   mapFECGrp(i);
+}
+
 bool
 CirMgr::randomCheckPoint() const
 {
@@ -276,9 +531,15 @@ CirMgr::randomCheckPoint() const
    }
 
    if(fecGrps.size() == 0) return true;
+   // size of the group led by the smallest ID; fecGrps is not sorted here
+   unsigned grp0 = 0;
+   for(unsigned i = 1; i < fecGrps.size(); i++) {
+      if(CirGate::unmask((*fecGrps[i])[0])->getID() <
+         CirGate::unmask((*fecGrps[grp0])[0])->getID()) grp0 = i;
+   }
    if(fecs.size() < magicNumber && fec0.size() < magicNumber) {
       fecs.push_back(fecGrps.size());
-      fec0.push_back(fecGrps[0]->size());
+      fec0.push_back(fecGrps[grp0]->size());
       return false;
    }
    for(unsigned i = 0; i < magicNumber - 1; i++) {
@@ -286,7 +547,7 @@ CirMgr::randomCheckPoint() const
       fec0[i] = fec0[i+1];
    }
    fecs[magicNumber - 1] = fecGrps.size();
-   fec0[magicNumber - 1] = fecGrps[0]->size();
+   fec0[magicNumber - 1] = fecGrps[grp0]->size();
    for(unsigned i = 0; i < magicNumber - 1; i++) {
       if((fecs[i] != fecs[i+1]) ||
          (fec0[i] != fec0[i+1])) return false;
@@ -294,50 +555,68 @@ CirMgr::randomCheckPoint() const
    return true;
 }
 
+// Write the last "patternNumber" patterns simulated; pattern k of a pass is
+// bit (63 - k % 64) of word (k / 64) in each gate's row of _simData
 void
 CirMgr::writeSimulationLog(unsigned patternNumber)
 {
    if(_simLog == 0) return;
-
-   patternNumber %= (sizeof(size_t) * 8);
-   if(patternNumber == 0) patternNumber = (sizeof(size_t) * 8);
-
-   vector<string> patternsPI;
-   patternsPI.resize(patternNumber);
-   vector<string> patternsPO;
-   patternsPO.resize(patternNumber);
-
-   for(unsigned i = 0; i < PIs.size(); i++) {
-      stringstream buf;
-      buf << PIs[i]->getSimValue();
-
-      string tmp = buf.str();
-      string str;
-      for(unsigned j = 0; j < tmp.size(); j++) {
-         if(tmp[j] != '_') str += tmp[j];
+   _simLogPatterns += patternNumber;
+
+   // binary: one block of PI rows then PO rows, padding patterns cleared
+   if(_simLogBinary) {
+      if(_simLog->tellp() == 0) {
+         PatternHeader h;
+         initPatternHeader(h, PIs.size(), POs.size(), _simWords);
+         _simLog->write((const char*)&h, sizeof(h));
       }
-
-      for(unsigned j = 0; j < patternNumber; j++) {
-         patternsPI[j] += str[str.size() - j - 1];
+      vector<size_t> block((PIs.size() + POs.size()) * _simWords);
+      for(unsigned i = 0; i < PIs.size() + POs.size(); i++) {
+         CirGate* g = (i < PIs.size()) ? PIs[i] : POs[i - PIs.size()];
+         copy(_simData.begin() + g->getID() * _simWords,
+              _simData.begin() + (g->getID() + 1) * _simWords,
+              block.begin() + i * _simWords);
+      }
+      for(unsigned w = 0; w < _simWords; w++) {
+         unsigned k = w * 64;
+         size_t mask = (k >= patternNumber) ? 0 :
+                       (patternNumber - k >= 64) ? ~size_t(0) :
+                       ~(~size_t(0) >> (patternNumber - k));
+         for(unsigned i = 0; i < PIs.size() + POs.size(); i++)
+            block[i * _simWords + w] &= mask;
       }
+      _simLog->write((const char*)block.data(), block.size() * sizeof(size_t));
+      return;
    }
 
-   for(unsigned i = 0; i < POs.size(); i++) {
-      stringstream buf;
-      buf << POs[i]->getSimValue();
+   unsigned sztbits = sizeof(size_t) * 8;
+   string line(PIs.size() + 1 + POs.size(), ' ');
 
-      string tmp = buf.str();
-      string str;
-      for(unsigned j = 0; j < tmp.size(); j++) {
-         if(tmp[j] != '_') str += tmp[j];
+   for(unsigned k = 0; k < patternNumber; k++) {
+      unsigned w = k / sztbits;
+      unsigned b = sztbits - 1 - k % sztbits;
+      for(unsigned i = 0; i < PIs.size(); i++) {
+         size_t word = _simData[PIs[i]->getID() * _simWords + w];
+         line[i] = '0' + ((word >> b) & 1);
       }
-
-      for(unsigned j = 0; j < patternNumber; j++) {
-         patternsPO[j] += str[str.size() - j - 1];
+      for(unsigned i = 0; i < POs.size(); i++) {
+         size_t word = _simData[POs[i]->getID() * _simWords + w];
+         line[PIs.size() + 1 + i] = '0' + ((word >> b) & 1);
       }
+      (*_simLog) << line << '\n';
    }
+}
 
-   for(unsigned i = 0; i < patternNumber; i++) {
-      (*_simLog) << patternsPI[i] << ' ' << patternsPO[i] << endl;
+// a binary log gets its final pattern count patched into the header
+void
+CirMgr::closeSimulationLog()
+{
+   if(_simLog != 0 && _simLogBinary) {
+      PatternHeader h;
+      initPatternHeader(h, PIs.size(), POs.size(), _simWords ? _simWords : 1);
+      h.nPatterns = _simLogPatterns;
+      _simLog->seekp(0);
+      _simLog->write((const char*)&h, sizeof(h));
    }
+   _simLog = 0;
 }
@@ -0,0 +1,118 @@
+/****************************************************************************
+  FileName     [ cirStrash.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the structural hash (unique) table of AIG nodes ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_STRASH_H
+#define CIR_STRASH_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Unique table of AIG nodes keyed on their two fanin literals (2 * ID +
+// inv), ordered so that (a, b) and (b, a) are the same key. Open addressing
+// with linear probing over a power-of-2 array of flat slots; the table
+// doubles whenever it gets more than half full
+class AigHash
+{
+public:
+   AigHash(unsigned n = 0) { init(n); }
+   ~AigHash() {}
+
+   // empty table with room for "n" nodes before it grows
+   void init(unsigned n) {
+      unsigned cap = 16;
+      while(cap < 2 * n) cap *= 2;
+      _slots.assign(cap, Slot());
+      _mask = cap - 1;
+      _size = 0;
+   }
+   unsigned size() const { return _size; }
+
+   // ID of the node with fanins (a, b), or UINT32_MAX if there is none
+   unsigned find(unsigned a, unsigned b) const {
+      uint64_t k = key(a, b);
+      for(unsigned i = hash(k) & _mask; ; i = (i + 1) & _mask) {
+         if(_slots[i].key == k) return _slots[i].id;
+         if(_slots[i].key == EMPTY) return UINT32_MAX;
+      }
+   }
+   // ID of the node with fanins (a, b); "id" is inserted if there is none
+   unsigned insert(unsigned a, unsigned b, unsigned id) {
+      if(2 * (_size + 1) > _slots.size()) grow();
+      uint64_t k = key(a, b);
+      unsigned i = hash(k) & _mask;
+      for(; _slots[i].key != EMPTY; i = (i + 1) & _mask)
+         if(_slots[i].key == k) return _slots[i].id;
+      _slots[i].key = k;
+      _slots[i].id = id;
+      _size++;
+      return id;
+   }
+   // removes (a, b) if it is the key of node "id"; the entries behind it
+   // are shifted back, so no tombstones are left
+   void erase(unsigned a, unsigned b, unsigned id) {
+      uint64_t k = key(a, b);
+      unsigned i = hash(k) & _mask;
+      for(; _slots[i].key != k; i = (i + 1) & _mask)
+         if(_slots[i].key == EMPTY) return;
+      if(_slots[i].id != id) return;
+      for(unsigned j = (i + 1) & _mask; _slots[j].key != EMPTY;
+          j = (j + 1) & _mask) {
+         // the entry at j may fill the hole at i if i is not before its home
+         unsigned h = hash(_slots[j].key) & _mask;
+         if(((j - h) & _mask) >= ((j - i) & _mask)) {
+            _slots[i] = _slots[j];
+            i = j;
+         }
+      }
+      _slots[i] = Slot();
+      _size--;
+   }
+
+private:
+   static const uint64_t EMPTY = ~uint64_t(0);
+
+   struct Slot {
+      Slot() : key(EMPTY), id(0) {}
+      uint64_t key;
+      unsigned id;
+   };
+
+   static uint64_t key(unsigned a, unsigned b) {
+      return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+   }
+   // finalizer of MurmurHash3: every key bit affects every hash bit
+   static unsigned hash(uint64_t k) {
+      k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+      k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+      k ^= k >> 33;
+      return unsigned(k);
+   }
+   void grow() {
+      vector<Slot> old;
+      old.swap(_slots);
+      _slots.assign(2 * old.size(), Slot());
+      _mask = _slots.size() - 1;
+      for(unsigned j = 0; j < old.size(); j++) {
+         if(old[j].key == EMPTY) continue;
+         unsigned i = hash(old[j].key) & _mask;
+         while(_slots[i].key != EMPTY) i = (i + 1) & _mask;
+         _slots[i] = old[j];
+      }
+   }
+
+   vector<Slot>   _slots;
+   unsigned       _mask;
+   unsigned       _size;
+};
+
+#endif // CIR_STRASH_H
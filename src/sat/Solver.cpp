@@ -21,17 +21,15 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "Sort.h"
 #include <cmath>
 
-int effLimit = INT_MAX;
-
 //=================================================================================================
 // Helper functions:
 
 
-void removeWatch(vec<Clause*>& ws, Clause* elem)
+void removeWatch(vec<Watcher>& ws, CRef elem)
 {
     if (ws.size() == 0) return;     // (skip lists that are already cleared)
     int j = 0;
-    for (; ws[j] != elem  ; j++) assert(j < ws.size());
+    for (; ws[j].cref != elem; j++) assert(j < ws.size());
     for (; j < ws.size()-1; j++) ws[j] = ws[j+1];
     ws.pop();
 }
@@ -60,7 +58,7 @@ void removeWatch(vec<Clause*>& ws, Clause* elem)
 |  Effect:
 |    Activity heuristics are updated.
 |________________________________________________________________________________________________@*/
-void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
+void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A, uint lbd)
 {
     assert(learnt || id == ClauseId_NULL);
     if (!ok) return;
@@ -106,7 +104,8 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
 
     }else{
         // Allocate clause:
-        Clause* c   = Clause_new(learnt, ps, id);
+        CRef    cr = ca.alloc(learnt, ps, id);
+        Clause& c  = ca[cr];
 
         if (learnt){
             // Put the second watch on the literal with highest decision level:
@@ -116,47 +115,129 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
                 if (level[var(ps[i])] > max)
                     max   = level[var(ps[i])],
                     max_i = i;
-            (*c)[1]     = ps[max_i];
-            (*c)[max_i] = ps[1];
+            c[1]     = ps[max_i];
+            c[max_i] = ps[1];
+            c.setLbd(lbd);
 
             // Bumping:
             claBumpActivity(c); // (newly learnt clauses should be considered active)
 
             // Enqueue asserting literal:
-            check(enqueue((*c)[0], c));
+            check(enqueue(c[0], cr));
 
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            learnts.push(c);
-            stats.learnts_literals += c->size();
+            attach(cr);
+            learnts.push(cr);
+            stats.learnts_literals += c.size();
 
         }else{
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            clauses.push(c);
-            stats.clauses_literals += c->size();
+            attach(cr);
+            clauses.push(cr);
+            stats.clauses_literals += c.size();
         }
     }
 }
 
 
-// Disposes a clauses and removes it from watcher lists. NOTE! Low-level; does NOT change the 'clauses' and 'learnts' vector.
+// Adds a clause that the problem clauses imply to the learnt clause database (where 'reduceDB()'
+// may drop it again). Its LBD is not known, so its size is taken as an upper bound.
 //
-void Solver::remove(Clause* c, bool just_dealloc)
+void Solver::addLearnt(const vec<Lit>& ps)
 {
-    if (!just_dealloc){
-        removeWatch(watches[index(~(*c)[0])], c),
-        removeWatch(watches[index(~(*c)[1])], c);
+    assert(decisionLevel() == 0 && proof == NULL);
+    if (!ok) return;
+
+    vec<Lit>    qs;
+    for (int i = 0; i < ps.size(); i++){
+        if (value(ps[i]) == l_True)
+            return;
+        if (value(ps[i]) != l_False)
+            qs.push(ps[i]);
+    }
+    if (qs.size() < 2){
+        newClause(qs);
+        return; }
+
+    CRef    cr = ca.alloc(true, qs);
+    ca[cr].setLbd(qs.size());
+    attach(cr);
+    learnts.push(cr);
+    stats.learnts_literals += qs.size();
+}
 
-        if (c->learnt()) stats.learnts_literals -= c->size();
-        else             stats.clauses_literals -= c->size();
 
-        if (proof != NULL) proof->deleted(c->id());
+// Appends the learnt clauses and the top-level assignments (as unit clauses) to 'out', each clause
+// followed by 'lit_Undef'. Satisfied learnt clauses are skipped and false literals left out.
+//
+void Solver::exportLearnts(vec<Lit>& out)
+{
+    assert(decisionLevel() == 0);
+    for (int i = 0; i < trail.size(); i++){
+        out.push(trail[i]);
+        out.push(lit_Undef); }
+
+    for (int i = 0; i < learnts.size(); i++){
+        const Clause& c = ca[learnts[i]];
+        if (simplify(c)) continue;
+        for (int j = 0; j < c.size(); j++)
+            if (value(c[j]) != l_False)
+                out.push(c[j]);
+        out.push(lit_Undef);
     }
+}
+
+
+// Puts a clause on the watcher lists of its first two literals.
+//
+void Solver::attach(CRef cr)
+{
+    const Clause& c = ca[cr];
+    vec<vec<Watcher> >& ws = (c.size() == 2) ? watchesBin : watches;
+    ws[index(~c[0])].push(Watcher(cr, c[1]));
+    ws[index(~c[1])].push(Watcher(cr, c[0]));
+}
+
+
+// Disposes a clauses and removes it from watcher lists. NOTE! Low-level; does NOT change the 'clauses' and 'learnts' vector.
+//
+void Solver::remove(CRef cr)
+{
+    const Clause& c = ca[cr];
+    vec<vec<Watcher> >& ws = (c.size() == 2) ? watchesBin : watches;
+    removeWatch(ws[index(~c[0])], cr),
+    removeWatch(ws[index(~c[1])], cr);
 
-    xfree(c);
+    if (c.learnt()) stats.learnts_literals -= c.size();
+    else            stats.clauses_literals -= c.size();
+
+    if (proof != NULL) proof->deleted(c.id());
+
+    ca.free(cr);
+}
+
+
+// A clause is locked if it is the reason of a current assignment. Binary clauses are propagated
+// without reordering their literals, so the implied literal may be either of the two.
+//
+bool Solver::locked(CRef cr) const
+{
+    const Clause& c = ca[cr];
+    if (reason[var(c[0])] == cr && value(c[0]) == l_True)
+        return true;
+    return c.size() == 2 && reason[var(c[1])] == cr && value(c[1]) == l_True;
+}
+
+
+// Returns the reason of 'x' with the implied literal first (see 'locked()').
+//
+Clause& Solver::reasonClause(Var x)
+{
+    assert(reason[x] != CRef_Undef);
+    Clause& c = ca[reason[x]];
+    if (c.size() == 2 && value(c[0]) == l_False){
+        Lit tmp = c[0]; c[0] = c[1]; c[1] = tmp; }
+    return c;
 }
 
 
@@ -164,11 +245,11 @@ void Solver::remove(Clause* c, bool just_dealloc)
 // the clause is binary and satisfied, in which case the first literal is true)
 // Returns True if clause is satisfied (will be removed), False otherwise.
 //
-bool Solver::simplify(Clause* c) const
+bool Solver::simplify(const Clause& c) const
 {
     assert(decisionLevel() == 0);
-    for (int i = 0; i < c->size(); i++){
-        if (value((*c)[i]) == l_True)
+    for (int i = 0; i < c.size(); i++){
+        if (value(c[i]) == l_True)
             return true;
     }
     return false;
@@ -179,19 +260,24 @@ bool Solver::simplify(Clause* c) const
 // Minor methods:
 
 
-// Creates a new SAT variable in the solver. If 'decision_var' is cleared, variable will not be
+// Creates a new SAT variable in the solver. If 'dvar' is cleared, variable will not be
 // used as a decision variable (NOTE! This has effects on the meaning of a SATISFIABLE result).
 //
-Var Solver::newVar() {
+Var Solver::newVar(bool dvar) {
     int     index;
     index = nVars();
     watches     .push();          // (list for positive literal)
     watches     .push();          // (list for negative literal)
-    reason      .push(NULL);
+    watchesBin  .push();
+    watchesBin  .push();
+    lbd_seen    .push(0);
+    reason      .push(CRef_Undef);
     assigns     .push(toInt(l_Undef));
     level       .push(-1);
     trail_pos   .push(-1);
     activity    .push(0);
+    polarity    .push(1);
+    decision    .push(dvar);
     order       .newVar();
     analyze_seen.push(0);
     if (proof != NULL) unit_id.push(ClauseId_NULL);
@@ -210,7 +296,8 @@ void Solver::cancelUntil(int level) {
         for (int c = trail.size()-1; c >= trail_lim[level]; c--){
             Var     x  = var(trail[c]);
             assigns[x] = toInt(l_Undef);
-            reason [x] = NULL;
+            reason [x] = CRef_Undef;
+            if (phase_saving) polarity[x] = sign(trail[c]);
             order.undo(x); }
         trail.shrink(trail.size() - trail_lim[level]);
         trail_lim.shrink(trail_lim.size() - level);
@@ -223,7 +310,7 @@ void Solver::cancelUntil(int level) {
 
 /*_________________________________________________________________________________________________
 |
-|  analyze : (confl : Clause*) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
+|  analyze : (confl : CRef) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
 |  
 |  Description:
 |    Analyze conflict and produce a reason clause ('out_learnt') and a backtracking level
@@ -244,7 +331,7 @@ public:
     lastToFirst_lt(const vec<int>& t) : trail_pos(t) {}
     bool operator () (Lit p, Lit q) { return trail_pos[var(p)] > trail_pos[var(q)]; }
 };
-void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
+void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
 {
     vec<char>&     seen  = analyze_seen;
     int            pathC = 0;
@@ -252,16 +339,21 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
     // Generate conflict clause:
     //
-    if (proof != NULL) proof->beginChain(confl->id());
+    if (proof != NULL) proof->beginChain(ca[confl].id());
     out_learnt.push();          // (leave room for the asserting literal)
     out_btlevel = 0;
     int index = trail.size()-1;
     for(;;){
-        assert(confl != NULL);  // (otherwise should be UIP)
-
-        Clause& c = *confl;
-        if (c.learnt())
-            claBumpActivity(&c);
+        assert(confl != CRef_Undef);  // (otherwise should be UIP)
+
+        Clause& c = (p == lit_Undef) ? ca[confl] : reasonClause(var(p));
+        if (c.learnt()){
+            claBumpActivity(c);
+            c.setUsed(true);
+            if (c.lbd() > 2){
+                uint lbd = computeLBD(c);       // (all literals are assigned; keep the best LBD seen)
+                if (lbd < c.lbd()) c.setLbd(lbd); }
+        }
 
         for (int j = (p == lit_Undef) ? 0 : 1; j < c.size(); j++){
             Lit q = c[j];
@@ -288,7 +380,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         pathC--;
         if (pathC == 0) break;
 
-        if (proof != NULL) proof->resolve(confl->id(), ~p);
+        if (proof != NULL) proof->resolve(ca[confl].id(), ~p);
     }
     out_learnt[0] = ~p;
 
@@ -304,18 +396,17 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++)
-            if (reason[var(out_learnt[i])] == NULL || !analyze_removable(out_learnt[i], min_level))
+            if (reason[var(out_learnt[i])] == CRef_Undef || !analyze_removable(out_learnt[i], min_level))
                 out_learnt[j++] = out_learnt[i];
     }else if(expensive_ccmin == 1){
         // Simplify conflict clause (a little):
         //
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++){
-            Clause* r = reason[var(out_learnt[i])];
-            if (r == NULL)
+            if (reason[var(out_learnt[i])] == CRef_Undef)
                 out_learnt[j++] = out_learnt[i];
             else{
-                Clause& c = *r;
+                Clause& c = reasonClause(var(out_learnt[i]));
                 for (int k = 1; k < c.size(); k++)
                     if (!seen[var(c[k])] && level[var(c[k])] != 0){
                         out_learnt[j++] = out_learnt[i];
@@ -334,7 +425,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         for (int k = 0; k < analyze_toclear.size(); k++){
             Var     v = var(analyze_toclear[k]); assert(level[v] > 0);
 				Lit     l = analyze_toclear[k];
-            Clause& c = *reason[v];
+            Clause& c = reasonClause(v);
             proof->resolve(c.id(), l);
             for (int k = 1; k < c.size(); k++)
                 if (level[var(c[k])] == 0)
@@ -357,17 +448,16 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 //
 bool Solver::analyze_removable(Lit p, uint min_level)
 {
-    assert(reason[var(p)] != NULL);
+    assert(reason[var(p)] != CRef_Undef);
     analyze_stack.clear(); analyze_stack.push(p);
     int top = analyze_toclear.size();
     while (analyze_stack.size() > 0){
-        assert(reason[var(analyze_stack.last())] != NULL);
-        Clause& c = *reason[var(analyze_stack.last())];
+        Clause& c = reasonClause(var(analyze_stack.last()));
         analyze_stack.pop();
         for (int i = 1; i < c.size(); i++){
             Lit p = c[i];
             if (!analyze_seen[var(p)] && level[var(p)] != 0){
-                if (reason[var(p)] != NULL && ((1 << (level[var(p)] & 31)) & min_level) != 0){
+                if (reason[var(p)] != CRef_Undef && ((1 << (level[var(p)] & 31)) & min_level) != 0){
                     analyze_seen[var(p)] = 1;
                     analyze_stack.push(p);
                     analyze_toclear.push(p);
@@ -388,7 +478,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 
 /*_________________________________________________________________________________________________
 |
-|  analyzeFinal : (confl : Clause*) (skip_first : bool)  ->  [void]
+|  analyzeFinal : (confl : CRef) (skip_first : bool)  ->  [void]
 |  
 |  Description:
 |    Specialized analysis procedure to express the final conflict in terms of assumptions.
@@ -396,7 +486,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 |    making assumptions). If 'skip_first' is TRUE, the first literal of 'confl' is  ignored (needed
 |    if conflict arose before search even started).
 |________________________________________________________________________________________________@*/
-void Solver::analyzeFinal(Clause* confl, bool skip_first)
+void Solver::analyzeFinal(CRef confl, bool skip_first)
 {
     // -- NOTE! This code is relatively untested. Please report bugs!
     conflict.clear();
@@ -405,10 +495,11 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         return; }
    //assert(false);
     vec<char>&     seen  = analyze_seen;
-    if (proof != NULL) proof->beginChain(confl->id());
-    for (int i = skip_first ? 1 : 0; i < confl->size(); i++){
-        Var     x = var((*confl)[i]);
-		  Lit		 l = (*confl)[i];
+    Clause&        cc    = skip_first ? reasonClause(var(ca[confl][0])) : ca[confl];
+    if (proof != NULL) proof->beginChain(cc.id());
+    for (int i = skip_first ? 1 : 0; i < cc.size(); i++){
+        Var     x = var(cc[i]);
+		  Lit		 l = cc[i];
         if (level[x] > 0)
             seen[x] = 1;
         else
@@ -420,12 +511,11 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         Var     x = var(trail[i]);
 		  Lit     l = trail[i];
         if (seen[x]){
-            Clause* r = reason[x];
-            if (r == NULL){
+            if (reason[x] == CRef_Undef){
                 assert(level[x] > 0);
                 conflict.push(~trail[i]);
             }else{
-                Clause& c = *r;
+                Clause& c = reasonClause(x);
                 if (proof != NULL) proof->resolve(c.id(), l);
                 for (int j = 1; j < c.size(); j++)
                     if (level[var(c[j])] > 0)
@@ -442,7 +532,7 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 
 /*_________________________________________________________________________________________________
 |
-|  enqueue : (p : Lit) (from : Clause*)  ->  [bool]
+|  enqueue : (p : Lit) (from : CRef)  ->  [bool]
 |  
 |  Description:
 |    Puts a new fact on the propagation queue as well as immediately updating the variable's value.
@@ -451,12 +541,12 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 |  Input:
 |    p    - The fact to enqueue
 |    from - [Optional] Fact propagated from this (currently) unit clause. Stored in 'reason[]'.
-|           Default value is NULL (no reason).
+|           Default value is CRef_Undef (no reason).
 |  
 |  Output:
 |    TRUE if fact was enqueued without conflict, FALSE otherwise.
 |________________________________________________________________________________________________@*/
-bool Solver::enqueue(Lit p, Clause* from)
+bool Solver::enqueue(Lit p, CRef from)
 {
     if (value(p) != l_Undef)
         return value(p) != l_False;
@@ -475,78 +565,88 @@ bool Solver::enqueue(Lit p, Clause* from)
 
 /*_________________________________________________________________________________________________
 |
-|  propagate : [void]  ->  [Clause*]
+|  propagate : [void]  ->  [CRef]
 |  
 |  Description:
 |    Propagates all enqueued facts. If a conflict arises, the conflicting clause is returned,
-|    otherwise NULL. NOTE! This method has been optimized for speed rather than readability.
+|    otherwise CRef_Undef. NOTE! This method has been optimized for speed rather than readability.
 |  
 |    Post-conditions:
 |      * The propagation queue is empty, even if there was a conflict.
 |________________________________________________________________________________________________@*/
-Clause* Solver::propagate()
+CRef Solver::propagate()
 {
-    Clause* confl = NULL;
+    CRef    confl = CRef_Undef;
     while (qhead < trail.size()){
         stats.propagations++;
         simpDB_props--;
 
         Lit            p  = trail[qhead++];     // 'p' is enqueued fact to propagate.
-        vec<Clause*>&  ws = watches[index(p)];
-        Clause**       i,** j,** end;
+        Lit     false_lit = ~p;
+
+        // Binary clauses -- the other literal is in the watcher:
+        vec<Watcher>&  wbin = watchesBin[index(p)];
+        for (int k = 0; k < wbin.size(); k++){
+            Lit imp = wbin[k].blocker;
+            if (value(imp) == l_True) continue;
+
+            if (decisionLevel() == 0 && proof != NULL)
+                logUnit(ca[wbin[k].cref], imp);
+            if (!enqueue(imp, wbin[k].cref)){
+                if (decisionLevel() == 0)
+                    ok = false;
+                confl = wbin[k].cref;
+                qhead = trail.size();
+                break;
+            }
+        }
+        if (confl != CRef_Undef) break;
+
+        vec<Watcher>&  ws = watches[index(p)];
+        Watcher        *i, *j, *end;
+
+        for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
+            // Try to avoid inspecting the clause:
+            Lit blocker = i->blocker;
+            if (value(blocker) == l_True){
+                *j++ = *i++; continue; }
 
-        for (i = j = (Clause**)ws, end = i + ws.size();  i != end;){
-            Clause& c = **i; i++;
             // Make sure the false literal is data[1]:
-            Lit false_lit = ~p;
+            CRef    cr = i->cref;
+            Clause& c  = ca[cr];
             if (c[0] == false_lit)
                 c[0] = c[1], c[1] = false_lit;
-
             assert(c[1] == false_lit);
+            i++;
 
             // If 0th watch is true, then clause is already satisfied.
-            Lit   first = c[0];
-            lbool val   = value(first);
-            if (val == l_True){
-                *j++ = &c;
-            }else{
-                // Look for new watch:
-                for (int k = 2; k < c.size(); k++)
-                    if (value(c[k]) != l_False){
-                        c[1] = c[k]; c[k] = false_lit;
-                        watches[index(~c[1])].push(&c);
-                        goto FoundWatch; }
-
-                // Did not find watch -- clause is unit under assignment:
-                if (decisionLevel() == 0 && proof != NULL){
-                    // Log the production of this unit clause:
-                    proof->beginChain(c.id());
-                    for (int k = 1; k < c.size(); k++)
-                        proof->resolve(unit_id[var(c[k])], c[k]);
-                    ClauseId id = proof->endChain();
-                    assert(unit_id[var(first)] == ClauseId_NULL || value(first) == l_False);    // (if variable already has 'id', it must be with the other polarity and we should have derived the empty clause here)
-                    if (value(first) != l_False)
-                        unit_id[var(first)] = id;
-                    else{
-                        // Empty clause derived:
-                        proof->beginChain(unit_id[var(first)]);
-                        proof->resolve(id, ~first);
-                        proof->endChain();
-                    }
-                }
-					 
-                *j++ = &c;
-                if (!enqueue(first, &c)){
-                    if (decisionLevel() == 0)
-                        ok = false;
-                    confl = &c;
-                    qhead = trail.size();
-                    // Copy the remaining watches:
-                    while (i < end)
-                        *j++ = *i++;
-                }
-              FoundWatch:;
+            Lit     first = c[0];
+            Watcher w     = Watcher(cr, first);
+            if (first != blocker && value(first) == l_True){
+                *j++ = w; continue; }
+
+            // Look for new watch:
+            for (int k = 2; k < c.size(); k++)
+                if (value(c[k]) != l_False){
+                    c[1] = c[k]; c[k] = false_lit;
+                    watches[index(~c[1])].push(w);
+                    goto FoundWatch; }
+
+            // Did not find watch -- clause is unit under assignment:
+            if (decisionLevel() == 0 && proof != NULL)
+                logUnit(c, first);
+
+            *j++ = w;
+            if (!enqueue(first, cr)){
+                if (decisionLevel() == 0)
+                    ok = false;
+                confl = cr;
+                qhead = trail.size();
+                // Copy the remaining watches:
+                while (i < end)
+                    *j++ = *i++;
             }
+          FoundWatch:;
         }
         ws.shrink(i - j);
     }
@@ -555,34 +655,65 @@ Clause* Solver::propagate()
 }
 
 
+// Log the production of the top-level unit clause 'first' by 'c':
+//
+void Solver::logUnit(const Clause& c, Lit first)
+{
+    proof->beginChain(c.id());
+    for (int k = 0; k < c.size(); k++)
+        if (c[k] != first)
+            proof->resolve(unit_id[var(c[k])], c[k]);
+    ClauseId id = proof->endChain();
+    assert(unit_id[var(first)] == ClauseId_NULL || value(first) == l_False);    // (if variable already has 'id', it must be with the other polarity and we should have derived the empty clause here)
+    if (value(first) != l_False)
+        unit_id[var(first)] = id;
+    else{
+        // Empty clause derived:
+        proof->beginChain(unit_id[var(first)]);
+        proof->resolve(id, ~first);
+        proof->endChain();
+    }
+}
+
+
 /*_________________________________________________________________________________________________
 |
-|  reduceDB : ()  ->  [void]
+|  reduceDB : (params : const SearchParams&)  ->  [void]
 |  
 |  Description:
-|    Remove half of the learnt clauses, minus the clauses locked by the current assignment. Locked
-|    clauses are clauses that are reason to some assignment. Binary clauses are never removed.
+|    Remove the worse half of the learnt clauses (highest LBD first, then lowest activity), minus
+|    the clauses locked by the current assignment. Locked clauses are clauses that are reason to
+|    some assignment. Binary clauses and core clauses ('lbd <= core_lbd') are never removed;
+|    tier-2 clauses ('lbd <= tier2_lbd') are kept as long as they took part in a conflict since
+|    the previous call.
 |________________________________________________________________________________________________@*/
-struct reduceDB_lt { bool operator () (Clause* x, Clause* y) { return x->size() > 2 && (y->size() == 2 || x->activity() < y->activity()); } };
-void Solver::reduceDB()
+struct reduceDB_lt {
+    ClauseAllocator& ca;
+    reduceDB_lt(ClauseAllocator& ca_) : ca(ca_) { }
+    bool operator () (CRef x, CRef y) {
+        const Clause& a = ca[x];
+        const Clause& b = ca[y];
+        return a.size() > 2 && (b.size() == 2 || a.lbd() > b.lbd() || (a.lbd() == b.lbd() && a.activity() < b.activity())); } };
+void Solver::reduceDB(const SearchParams& params)
 {
     int     i, j;
     double  extra_lim = cla_inc / learnts.size();    // Remove any clause below this activity
 
-    sort(learnts, reduceDB_lt());
-    for (i = j = 0; i < learnts.size() / 2; i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]))
-            remove(learnts[i]);
-        else
+    sort(learnts, reduceDB_lt(ca));
+    learnts_core = 0;
+    for (i = j = 0; i < learnts.size(); i++){
+        Clause& c    = ca[learnts[i]];
+        bool    core = c.size() == 2 || c.lbd() <= params.core_lbd;
+        if (core || locked(learnts[i]) || (c.used() && c.lbd() <= params.tier2_lbd)
+                 || (i >= learnts.size() / 2 && c.activity() >= extra_lim)){
+            c.setUsed(false);
+            learnts_core += core;
             learnts[j++] = learnts[i];
-    }
-    for (; i < learnts.size(); i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]) && learnts[i]->activity() < extra_lim)
+        }else
             remove(learnts[i]);
-        else
-            learnts[j++] = learnts[i];
     }
     learnts.shrink(i - j);
+    checkGarbage();
 }
 
 
@@ -599,7 +730,7 @@ void Solver::simplifyDB()
     if (!ok) return;    // GUARD (public method)
     assert(decisionLevel() == 0);
 
-    if (propagate() != NULL){
+    if (propagate() != CRef_Undef){
         ok = false;
         return; }
 
@@ -609,43 +740,79 @@ void Solver::simplifyDB()
     // Clear watcher lists:
     for (int i = simpDB_assigns; i < nAssigns(); i++){
         Lit p = trail[i];
-        watches[index( p)].clear(true);
-        watches[index(~p)].clear(true);
+        watches   [index( p)].clear(true);
+        watches   [index(~p)].clear(true);
+        watchesBin[index( p)].clear(true);
+        watchesBin[index(~p)].clear(true);
     }
 
     // Remove satisfied clauses:
     for (int type = 0; type < 2; type++){
-        vec<Clause*>& cs = type ? learnts : clauses;
+        vec<CRef>&    cs = type ? learnts : clauses;
         int           j  = 0;
         for (int i = 0; i < cs.size(); i++){
-            if (!locked(cs[i]) && simplify(cs[i]))
+            if (!locked(cs[i]) && simplify(ca[cs[i]]))
                 remove(cs[i]);
             else
                 cs[j++] = cs[i];
         }
         cs.shrink(cs.size()-j);
     }
+    checkGarbage();
 
     simpDB_assigns = nAssigns();
     simpDB_props   = stats.clauses_literals + stats.learnts_literals;   // (shouldn't depend on 'stats' really, but it will do for now)
 }
 
 
+// Moves every live clause into 'to', updating all references to it.
+//
+void Solver::relocAll(ClauseAllocator& to)
+{
+    for (int i = 0; i < watches.size(); i++){
+        for (int j = 0; j < watches[i].size(); j++)
+            ca.reloc(watches[i][j].cref, to);
+        for (int j = 0; j < watchesBin[i].size(); j++)
+            ca.reloc(watchesBin[i][j].cref, to);
+    }
+    for (int i = 0; i < trail.size(); i++){
+        Var v = var(trail[i]);
+        if (reason[v] != CRef_Undef)
+            ca.reloc(reason[v], to);
+    }
+    for (int i = 0; i < learnts.size(); i++)
+        ca.reloc(learnts[i], to);
+    for (int i = 0; i < clauses.size(); i++)
+        ca.reloc(clauses[i], to);
+}
+
+
+// Compacts the clause arena once enough of it is wasted by removed clauses (see 'checkGarbage()').
+//
+void Solver::collectArena()
+{
+    ClauseAllocator to;
+    relocAll(to);
+    to.moveTo(ca);
+}
+
+
 /*_________________________________________________________________________________________________
 |
-|  search : (nof_conflicts : int) (nof_learnts : int) (params : const SearchParams&)  ->  [lbool]
+|  search : (nof_conflicts : int) (params : const SearchParams&)  ->  [lbool]
 |  
 |  Description:
-|    Search for a model the specified number of conflicts, keeping the number of learnt clauses
-|    below the provided limit. NOTE! Use negative value for 'nof_conflicts' or 'nof_learnts' to
-|    indicate infinity.
+|    Search for a model the specified number of conflicts (or, for glucose restarts, until the
+|    recent conflicts look worse than average), keeping the number of learnt clauses below
+|    'max_learnts'. NOTE! Use negative value for 'nof_conflicts' or 'max_learnts' to indicate
+|    infinity.
 |  
 |  Output:
 |    'l_True' if a partial assigment that is consistent with respect to the clauseset is found. If
 |    all variables are decision variables, this means that the clause set is satisfiable. 'l_False'
 |    if the clause set is unsatisfiable. 'l_Undef' if the bound on number of conflicts is reached.
 |________________________________________________________________________________________________@*/
-lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& params)
+lbool Solver::search(int nof_conflicts, const SearchParams& params)
 {
     if (!ok) return l_False;    // GUARD (public method)
     assert(root_level == decisionLevel());
@@ -657,8 +824,8 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
     model.clear();
 
     for (;;){
-        Clause* confl = propagate();
-        if (confl != NULL){
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             // CONFLICT
 
             stats.conflicts++; conflictC++;
@@ -669,18 +836,35 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 analyzeFinal(confl);
                 return l_False; }
             analyze(confl, learnt_clause, backtrack_level);
+            uint lbd = computeLBD(learnt_clause);
+            lbd_queue.push(lbd);
+            lbd_sum += lbd;
+            if (params.restart == restart_Glucose && stats.conflicts > 10000 && lbd_queue.isFull()
+             && trail_queue.isFull() && trail.size() > params.glucose_r * trail_queue.avg())
+                lbd_queue.clear();      // (block the restart: the solver may be close to a model)
+            trail_queue.push(trail.size());
+
             cancelUntil(max(backtrack_level, root_level));
-            newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL);
+            newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL, true, lbd);
             if (learnt_clause.size() == 1) level[var(learnt_clause[0])] = 0;    // (this is ugly (but needed for 'analyzeFinal()') -- in future versions, we will backtrack past the 'root_level' and redo the assumptions)
             varDecayActivity();
             claDecayActivity();
 
+            if (max_learnts >= 0 && --learntsize_adjust_cnt == 0){
+                learntsize_adjust_confl *= 1.5;
+                learntsize_adjust_cnt    = (int)learntsize_adjust_confl;
+                max_learnts             *= 1.1; }
+
         }else{
             // NO CONFLICT
 
-            if (nof_conflicts >= 0 && conflictC >= nof_conflicts){
+            bool restart = (params.restart == restart_Glucose)
+                         ? lbd_queue.isFull() && lbd_queue.avg() * params.glucose_k > lbd_sum / stats.conflicts
+                         : nof_conflicts >= 0 && conflictC >= nof_conflicts;
+            if (restart || !withinBudget()){
                 // Reached bound on number of conflicts:
                 progress_estimate = progressEstimate();
+                lbd_queue.clear();
                 cancelUntil(root_level);
                 return l_Undef; }
 
@@ -688,15 +872,15 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 // Simplify the set of problem clauses:
                 simplifyDB(), assert(ok);
 
-            if (nof_learnts >= 0 && learnts.size()-nAssigns() >= nof_learnts)
+            if (max_learnts >= 0 && learnts.size()-learnts_core-nAssigns() >= max_learnts)
                 // Reduce the set of learnt clauses:
-                reduceDB();
+                reduceDB(params);
 
             // New variable decision:
             stats.decisions++;
-            Var next = order.select(params.random_var_freq);
+            Lit next = pickBranchLit(params);
 
-            if (next == var_Undef){
+            if (next == lit_Undef){
                 // Model found:
                 model.growTo(nVars());
                 for (int i = 0; i < nVars(); i++) model[i] = value(i);
@@ -704,12 +888,23 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 return l_True;
             }
 
-            check(assume(~Lit(next)));
+            check(assume(next));
         }
     }
 }
 
 
+// Picks the next decision: the most active unassigned decision variable (or, with probability
+// 'random_var_freq', a random one) in its preferred polarity. Returns 'lit_Undef' if every decision
+// variable is assigned.
+//
+Lit Solver::pickBranchLit(const SearchParams& params)
+{
+    Var next = order.select(params.random_var_freq);
+    return next == var_Undef ? lit_Undef : Lit(next, polarity[next]);
+}
+
+
 // Return search-space coverage. Not extremely reliable.
 //
 double Solver::progressEstimate()
@@ -738,17 +933,45 @@ void Solver::varRescaleActivity()
 void Solver::claRescaleActivity()
 {
     for (int i = 0; i < learnts.size(); i++)
-        learnts[i]->activity() *= 1e-20;
+        ca[learnts[i]].activity() *= 1e-20;
     cla_inc *= 1e-20;
 }
 
 
+/*
+  Finite subsequences of the Luby-sequence:
+
+  0: 1
+  1: 1 1 2
+  2: 1 1 2 1 1 2 4
+  3: 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8
+  ...
+
+  Returns 'y' to the power of the 'x':th term.
+ */
+static double luby(double y, int x)
+{
+    // Find the finite subsequence that contains index 'x', and the size of that subsequence:
+    int size, seq;
+    for (size = 1, seq = 0; size < x+1; seq++, size = 2*size+1);
+
+    while (size-1 != x){
+        size = (size-1)>>1;
+        seq--;
+        x = x % size;
+    }
+
+    return pow(y, seq);
+}
+
+
 /*_________________________________________________________________________________________________
 |
-|  solve : (assumps : const vec<Lit>&)  ->  [bool]
+|  solveLimited : (assumps : const vec<Lit>&)  ->  [lbool]
 |  
 |  Description:
-|    Top-level solve. If using assumptions (non-empty 'assumps' vector), you must call
+|    Top-level solve. Returns 'l_Undef' if the budget set by 'setConfBudget()'/'setPropBudget()'
+|    runs out before the problem is decided. If using assumptions (non-empty 'assumps' vector), you must call
 |    'simplifyDB()' first to see that no top-level conflict is present (which would put the solver
 |    in an undefined state).
 |  
@@ -756,15 +979,20 @@ void Solver::claRescaleActivity()
 |    A list of assumptions (unit clauses coded as literals). Pre-condition: The assumptions must
 |    not contain both 'x' and '~x' for any variable 'x'.
 |________________________________________________________________________________________________@*/
-bool Solver::solve(const vec<Lit>& assumps)
+lbool Solver::solveLimited(const vec<Lit>& assumps)
 {
     simplifyDB();
-    if (!ok) return false;
+    if (!ok) return l_False;
 
     SearchParams    params(default_params);
-    double  nof_conflicts = 100;
-    double  nof_learnts   = nClauses() / 3;
+    double  nof_conflicts = params.restart_first;
+    int     curr_restarts = 0;
     lbool   status        = l_Undef;
+    max_learnts             = nClauses() / 3;
+    learntsize_adjust_confl = 100;
+    learntsize_adjust_cnt   = 100;
+    lbd_queue  .clear();
+    trail_queue.clear();
 
     // Perform assumptions:
     root_level = assumps.size();
@@ -772,7 +1000,7 @@ bool Solver::solve(const vec<Lit>& assumps)
         Lit p = assumps[i];
         assert(var(p) < nVars());
         if (!assume(p)){
-            if (reason[var(p)] != NULL){
+            if (reason[var(p)] != CRef_Undef){
                 analyzeFinal(reason[var(p)], true);
                 conflict.push(~p);
             }else{
@@ -782,12 +1010,12 @@ bool Solver::solve(const vec<Lit>& assumps)
                 if (proof != NULL) conflict_id = unit_id[var(p)];
             }
             cancelUntil(0);
-            return false; }
-        Clause* confl = propagate();
-        if (confl != NULL){
+            return l_False; }
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             analyzeFinal(confl), assert(conflict.size() > 0);
             cancelUntil(0);
-            return false; }
+            return l_False; }
     }
     assert(root_level == decisionLevel());
 
@@ -803,26 +1031,26 @@ bool Solver::solve(const vec<Lit>& assumps)
         reportf("===================================\n");
     }
 
-    while (status == l_Undef){
+    while (status == l_Undef && withinBudget()){
         if (verbosity >= 1){
             printStats();
             reportf("| %9d | %7d %8d | %7d %7d %8d %7.1f | %6.3f %% |\n",
                    (int)stats.conflicts, nClauses(),
                    (int)stats.clauses_literals,
-                   (int)nof_learnts, nLearnts(),
+                   (int)max_learnts, nLearnts(),
                    (int)stats.learnts_literals,
                    (double)stats.learnts_literals/nLearnts(),
                    progress_estimate*100);
             fflush(stdout);
         }
-        status = search((int)nof_conflicts, (int)nof_learnts, params);
-        nof_conflicts *= 1.5;
-        nof_learnts   *= 1.1;
-
-if ((int)stats.conflicts >= effLimit) {
-   cancelUntil(0);
-   return status == l_True;
-}
+        if (params.restart == restart_Luby)
+            status = search((int)(params.restart_first * luby(params.restart_inc, curr_restarts)), params);
+        else if (params.restart == restart_Glucose)
+            status = search(-1, params);
+        else{
+            status = search((int)nof_conflicts, params);
+            nof_conflicts *= params.restart_inc; }
+        curr_restarts++;
     }
     if (verbosity >= 1) {
         reportf("===========================================");
@@ -830,7 +1058,7 @@ if ((int)stats.conflicts >= effLimit) {
     }
 
     cancelUntil(0);
-    return status == l_True;
+    return status;
 }
 
 void Solver::printStats()
@@ -40,9 +40,54 @@ struct SolverStats {
 };
 
 
+// Watch list entry. For clauses of 3+ literals, 'blocker' is some other literal of the clause; if it
+// is true the clause is satisfied and need not be visited. Binary clauses have their own watch lists
+// in which 'blocker' is the other literal, so they are propagated without touching the clause.
+struct Watcher {
+    CRef    cref;
+    Lit     blocker;
+    Watcher() : cref(CRef_Undef) { }
+    Watcher(CRef c, Lit b) : cref(c), blocker(b) { }
+};
+
+
+// Restart policies of 'solveLimited()':
+//   restart_Geometric -- restart after 'restart_first' conflicts, growing by a factor 'restart_inc' (the MiniSat 1.14 schedule).
+//   restart_Luby      -- restart after 'restart_first' times the next term of the Luby sequence with base 'restart_inc'.
+//   restart_Glucose   -- restart when the average LBD of the recent conflicts exceeds the overall average by a factor
+//                        1/'glucose_k'; a restart is postponed when the trail is 'glucose_r' times longer than usual.
+enum RestartPolicy { restart_Geometric, restart_Luby, restart_Glucose };
+
 struct SearchParams {
-    double  var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
-    SearchParams(double v = 1, double c = 1, double r = 0) : var_decay(v), clause_decay(c), random_var_freq(r) { }
+    double          var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
+    RestartPolicy   restart;
+    double          restart_first, restart_inc;                  // (reasonable values are: 100, 1.5 for geometric and 100, 2 for Luby restarts)
+    double          glucose_k, glucose_r;                        // (reasonable values are: 0.8, 1.4)
+    uint            core_lbd, tier2_lbd;                         // Learnts with LBD <= 'core_lbd' are never removed, learnts with LBD <= 'tier2_lbd' survive 'reduceDB()' while used.
+    SearchParams(double v = 1, double c = 1, double r = 0, RestartPolicy rp = restart_Geometric, double rf = 100, double ri = 1.5)
+      : var_decay(v), clause_decay(c), random_var_freq(r), restart(rp), restart_first(rf), restart_inc(ri)
+      , glucose_k(0.8), glucose_r(1.4), core_lbd(2), tier2_lbd(6) { }
+};
+
+
+// Sliding window over the last 'max_size' values pushed (for the glucose restart policy):
+class BoundedQueue {
+    vec<uint>   elems;
+    int         first, max_size;
+    uint64      sum;
+public:
+    BoundedQueue(int size) : first(0), max_size(size), sum(0) { }
+
+    void    push  (uint x) {
+        if (elems.size() == max_size){
+            sum -= elems[first]; elems[first] = x;
+            if (++first == max_size) first = 0;
+        }else
+            elems.push(x);
+        sum += x; }
+    bool    isFull() const { return elems.size() == max_size; }
+    double  avg   () const { return (double)sum / elems.size(); }
+    void    clear ()       { elems.clear(); first = 0; sum = 0; }
 };
 
 
@@ -51,8 +96,9 @@ protected:
     // Solver state:
     //
     bool                ok;               // If FALSE, the constraints are already unsatisfiable. No part of the solver state may be used!
-    vec<Clause*>        clauses;          // List of problem clauses.
-    vec<Clause*>        learnts;          // List of learnt clauses.
+    ClauseAllocator     ca;               // Memory of all clauses.
+    vec<CRef>           clauses;          // List of problem clauses.
+    vec<CRef>           learnts;          // List of learnt clauses.
     vec<ClauseId>       unit_id;          // 'unit_id[var]' is the clause ID for the unit literal 'var' or '~var' (if set at toplevel).
     double              cla_inc;          // Amount to bump next clause with.
     double              cla_decay;        // INVERSE decay factor for clause activity: stores 1/decay.
@@ -61,26 +107,38 @@ protected:
     double              var_inc;          // Amount to bump next variable with.
     double              var_decay;        // INVERSE decay factor for variable activity: stores 1/decay. Use negative value for static variable order.
     VarOrder            order;            // Keeps track of the decision variable order.
+    vec<char>           polarity;         // The preferred polarity of each variable: the sign of its last assignment if 'phase_saving' (initially negative).
+    vec<char>           decision;         // Declares if a variable is eligible for selection in the decision heuristic.
 
-    vec<vec<Clause*> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watchesBin;       // Same as 'watches[]', for binary clauses only.
     vec<char>           assigns;          // The current assignments (lbool:s stored as char:s).
     vec<Lit>            trail;            // Assignment stack; stores all assigments made in the order they were made.
     vec<int>            trail_lim;        // Separator indices for different decision levels in 'trail[]'.
-    vec<Clause*>        reason;           // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none.
+    vec<CRef>           reason;           // 'reason[var]' is the clause that implied the variables current value, or 'CRef_Undef' if none.
     vec<int>            level;            // 'level[var]' is the decision level at which assignment was made.
     vec<int>            trail_pos;        // 'trail_pos[var]' is the variable's position in 'trail[]'. This supersedes 'level[]' in some sense, and 'level[]' will probably be removed in future releases.
     int                 root_level;       // Level of first proper decision.
     int                 qhead;            // Head of queue (as index into the trail -- no more explicit propagation queue in MiniSat).
     int                 simpDB_assigns;   // Number of top-level assignments since last execution of 'simplifyDB()'.
     int64               simpDB_props;     // Remaining number of propagations that must be made before next execution of 'simplifyDB()'.
+    int64               conflict_budget;    // Value of 'stats.conflicts' at which 'solveLimited()' gives up (-1 means no budget).
+    int64               propagation_budget; // Value of 'stats.propagations' at which 'solveLimited()' gives up (-1 means no budget).
+    double              max_learnts;      // Number of (non-core) learnt clauses that triggers 'reduceDB()'; grows by 10% on a conflict clock.
+    double              learntsize_adjust_confl;
+    int                 learntsize_adjust_cnt;
+    int                 learnts_core;     // Number of learnt clauses 'reduceDB()' kept for good (binary or core LBD).
+    BoundedQueue        lbd_queue;        // LBDs of the most recent learnt clauses.
+    BoundedQueue        trail_queue;      // Trail sizes at the most recent conflicts.
+    double              lbd_sum;          // Sum of the LBDs of all learnt clauses.
 
     // Temporaries (to reduce allocation overhead). Each variable is prefixed by the method in which is used:
     //
     vec<char>           analyze_seen;
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
-    Clause*             propagate_tmpbin;
-    Clause*             analyze_tmpbin;
+    vec<uint>           lbd_seen;
+    uint                lbd_stamp;
     vec<Lit>            addUnit_tmp;
     vec<Lit>            addBinary_tmp;
     vec<Lit>            addTernary_tmp;
@@ -91,14 +149,15 @@ protected:
     void        cancelUntil      (int level);
     void        record           (const vec<Lit>& clause);
 
-    void        analyze          (Clause* confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
+    void        analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel);    // (bt = backtrack)
     bool        analyze_removable(Lit p, uint min_level);                                 // (helper method for 'analyze()')
-    void        analyzeFinal     (Clause* confl, bool skip_first = false);
-    bool        enqueue          (Lit fact, Clause* from = NULL);
-    Clause*     propagate        ();
-    void        reduceDB         ();
+    void        analyzeFinal     (CRef confl, bool skip_first = false);
+    bool        enqueue          (Lit fact, CRef from = CRef_Undef);
+    CRef        propagate        ();
+    void        logUnit          (const Clause& c, Lit first);                            // (helper method for 'propagate()')
+    void        reduceDB         (const SearchParams& params);
     Lit         pickBranchLit    (const SearchParams& params);
-    lbool       search           (int nof_conflicts, int nof_learnts, const SearchParams& params);
+    lbool       search           (int nof_conflicts, const SearchParams& params);
     double      progressEstimate ();
 
     // Activity:
@@ -114,11 +173,30 @@ protected:
 
     // Operations on clauses:
     //
-    void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true);
-    void     claBumpActivity (Clause* c) { if ( (c->activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
-    void     remove          (Clause* c, bool just_dealloc = false);
-    bool     locked          (const Clause* c) const { return reason[var((*c)[0])] == c; }
-    bool     simplify        (Clause* c) const;
+    void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true, uint lbd = 0);
+    void     claBumpActivity (Clause& c) { if ( (c.activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
+    void     attach          (CRef cr);
+    void     remove          (CRef cr);
+    bool     locked          (CRef cr) const;
+    bool     simplify        (const Clause& c) const;
+    Clause&  reasonClause    (Var x);
+
+    // Literal block distance -- the number of distinct decision levels among the (assigned) literals of 'c':
+    //
+    template<class C>
+    uint     computeLBD      (const C& c) {
+        uint n = 0;
+        lbd_stamp++;
+        for (int i = 0; i < c.size(); i++){
+            int l = level[var(c[i])];
+            if (lbd_seen[l] != lbd_stamp){ lbd_seen[l] = lbd_stamp; n++; } }
+        return n; }
+
+    // Arena garbage collection:
+    //
+    void     relocAll        (ClauseAllocator& to);
+    void     checkGarbage    () { if (ca.wasted() > ca.size() / 5) collectArena(); }
+    void     collectArena    ();
 
     int      decisionLevel() const { return trail_lim.size(); }
 
@@ -128,31 +206,35 @@ public:
              , cla_decay        (1)
              , var_inc          (1)
              , var_decay        (1)
-             , order            (assigns, activity)
+             , order            (assigns, decision, activity)
              , qhead            (0)
              , simpDB_assigns   (0)
              , simpDB_props     (0)
-             , default_params   (SearchParams(0.95, 0.999, 0.02))
+             , conflict_budget  (-1)
+             , propagation_budget(-1)
+             , max_learnts      (-1)
+             , learntsize_adjust_confl(0)
+             , learntsize_adjust_cnt  (0)
+             , learnts_core     (0)
+             , lbd_queue        (50)
+             , trail_queue      (5000)
+             , lbd_sum          (0)
+             , lbd_stamp        (0)
+             , default_params   (SearchParams(0.95, 0.999, 0.02, restart_Glucose))
              , expensive_ccmin  (2)
+             , phase_saving     (true)
              , proof            (NULL)
              , verbosity        (0)
              , progress_estimate(0)
              , conflict_id      (ClauseId_NULL)
              {
-                vec<Lit> dummy(2,lit_Undef);
-                propagate_tmpbin = Clause_new(false, dummy);
-                analyze_tmpbin   = Clause_new(false, dummy);
                 addUnit_tmp   .growTo(1);
                 addBinary_tmp .growTo(2);
                 addTernary_tmp.growTo(3);
+                lbd_seen      .push(0);     // (level 0; 'newVar()' adds one level per variable)
              }
 
-   ~Solver() {
-       for (int i = 0; i < learnts.size(); i++) remove(learnts[i], true);
-       for (int i = 0; i < clauses.size(); i++) if (clauses[i] != NULL) remove(clauses[i], true);
-       remove(propagate_tmpbin, true);
-       remove(analyze_tmpbin, true);
-    }
+   ~Solver() { }
 
     // Helpers: (semi-internal)
     //
@@ -173,12 +255,14 @@ public:
     //
     SearchParams    default_params;     // Restart frequency etc.
     int             expensive_ccmin;    // Controls conflict clause minimization. TRUE by default.
+    bool            phase_saving;       // Decide variables to the polarity they had when last unassigned. TRUE by default.
     Proof*          proof;              // Set this directly after constructing 'Solver' to enable proof logging. Initialized to NULL.
     int             verbosity;          // Verbosity level. 0=silent, 1=some progress report, 2=everything
 
     // Problem specification:
     //
-    Var     newVar    ();
+    Var     newVar    (bool dvar = true);
+    void    setDecisionVar(Var v, bool b) { decision[v] = b; if (b) order.undo(v); }
     int     nVars     ()                    { return assigns.size(); }
     void    addUnit   (Lit p)               { addUnit_tmp   [0] = p; addClause(addUnit_tmp); }
     void    addBinary (Lit p, Lit q)        { addBinary_tmp [0] = p; addBinary_tmp [1] = q; addClause(addBinary_tmp); }
@@ -190,9 +274,22 @@ public:
     //
     bool    okay() { return ok; }       // FALSE means solver is in an conflicting state (must never be used again!)
     void    simplifyDB();
-    bool    solve(const vec<Lit>& assumps);
+    void    garbageCollect() { simpDB_props = 0; simplifyDB(); }   // (unthrottled 'simplifyDB()', e.g. after retiring activation literals)
+    void    exportLearnts(vec<Lit>& out);       // (learnt clauses and top-level units, each closed by 'lit_Undef')
+    void    addLearnt(const vec<Lit>& ps);      // (a clause implied by the problem, e.g. exported by an earlier solver)
+    lbool   solveLimited(const vec<Lit>& assumps);
+    bool    solve(const vec<Lit>& assumps) { return solveLimited(assumps) == l_True; }
     bool    solve() { vec<Lit> tmp; return solve(tmp); }
 
+    // Budgets count from the time they are set and hold until 'budgetOff()':
+    //
+    void    setConfBudget(int64 x) { conflict_budget    = stats.conflicts    + x; }
+    void    setPropBudget(int64 x) { propagation_budget = stats.propagations + x; }
+    void    budgetOff()            { conflict_budget = propagation_budget = -1; }
+    bool    withinBudget() const   {
+        return (conflict_budget    < 0 || stats.conflicts    < conflict_budget)
+            && (propagation_budget < 0 || stats.propagations < propagation_budget); }
+
     double      progress_estimate;  // Set by 'search()'.
     vec<lbool>  model;              // If problem is satisfiable, this vector contains the model (if any).
     vec<Lit>    conflict;           // If problem is unsatisfiable under assumptions, this vector represent the conflict clause expressed in the assumptions.
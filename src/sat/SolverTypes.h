@@ -81,60 +81,94 @@ const   int ClauseId_NULL = INT_MIN;
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+// Clauses live in a 'ClauseAllocator' arena and are referred to by 32-bit word offsets ('CRef').
+// Layout: size and flag words, the literals, the activity (learnt clauses only) and the clause ID
+// (only if one was given, i.e. when logging proofs).
+typedef uint CRef;
+const   CRef CRef_Undef = UINT_MAX;
+
 class Clause {
-    uint    size_learnt;
+    uint    sz;
+    uint    flags;      // bit 0: learnt, bit 1: has ID, bit 2: relocated by 'ClauseAllocator::reloc()',
+                        // bit 3: used since the last 'reduceDB()', bits 4-31: LBD (learnt clauses only)
     Lit     data[1];
-public:
+
+    friend class ClauseAllocator;
     // NOTE: This constructor cannot be used directly (doesn't allocate enough memory).
-    Clause(bool learnt, const vec<Lit>& ps, ClauseId id_ = ClauseId_NULL) {
-        size_learnt = (ps.size() << 1) | (int)learnt;
+    Clause(bool learnt, const vec<Lit>& ps, ClauseId id_) {
+        sz    = ps.size();
+        flags = (uint)learnt | ((uint)(id_ != ClauseId_NULL) << 1);
         for (int i = 0; i < ps.size(); i++) data[i] = ps[i];
         if (learnt) activity() = 0;
         if (id_ != ClauseId_NULL) id() = id_; }
 
-    // -- use this function instead:
-    friend Clause* Clause_new(bool, const vec<Lit>&, ClauseId);
+public:
+    // Size in 32-bit words:
+    static int words(int size, bool learnt, bool has_id) { return 2 + size + (int)learnt + (int)has_id; }
 
-    int       size        ()      const { return size_learnt >> 1; }
-    bool      learnt      ()      const { return size_learnt & 1; }
+    int       size        ()      const { return sz; }
+    bool      learnt      ()      const { return flags & 1; }
+    bool      hasId       ()      const { return (flags >> 1) & 1; }
     Lit       operator [] (int i) const { return data[i]; }
     Lit&      operator [] (int i)       { return data[i]; }
     float&    activity    ()      const {
-        void *p = const_cast<Lit*>(&data[size()]); return *((float *)p);
-    } //              return *((float*)&data[size()]); }
-    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + (int)learnt()]); }
+        void *p = const_cast<Lit*>(&data[size()]); return *((float *)p); }
+    ClauseId& id          ()      const {
+        void *p = const_cast<Lit*>(&data[size() + (int)learnt()]); return *((ClauseId*)p); }
+
+    uint      lbd         ()      const { return flags >> 4; }
+    void      setLbd      (uint l)      { flags = (flags & 15) | (l << 4); }
+    bool      used        ()      const { return (flags >> 3) & 1; }
+    void      setUsed     (bool b)      { flags = (flags & ~8u) | ((uint)b << 3); }
+
+    bool      reloced     ()      const { return (flags >> 2) & 1; }
+    CRef      relocation  ()      const { return (CRef)index(data[0]); }
+    void      relocate    (CRef c)      { flags |= 4; data[0] = toLit((int)c); }
 };
 
-inline Clause* Clause_new(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
-    assert(sizeof(Lit)      == sizeof(uint));
-    assert(sizeof(float)    == sizeof(uint));
-    assert(sizeof(ClauseId) == sizeof(uint));
-    void*   mem = xmalloc<char>(sizeof(Clause) + sizeof(uint)*(ps.size() + (int)learnt + (int)(id != ClauseId_NULL)));
-    return new (mem) Clause(learnt, ps, id); }
-
 
 //=================================================================================================
-// GClause -- Generalize clause:
+// ClauseAllocator -- contiguous clause memory:
+
 
+// Freed clauses only count as wasted; the owner compacts the arena by moving every live clause
+// into a fresh allocator with 'reloc()' (which leaves a forwarding reference behind).
+class ClauseAllocator {
+    vec<uint>   mem;
+    int         wasted_;
 
-// Either a pointer to a clause or a literal.
-class GClause {
-    void*   data;
-    GClause(void* d) : data(d) {}
 public:
-    friend GClause GClause_new(Lit p);
-    friend GClause GClause_new(Clause* c);
-
-    bool        isLit    () const { return ((uintp)data & 1) == 1; }
-    Lit         lit      () const { return toLit(((intp)data) >> 1); }
-    Clause*     clause   () const { return (Clause*)data; }
-    bool        operator == (GClause c) const { return data == c.data; }
-    bool        operator != (GClause c) const { return data != c.data; }
+    ClauseAllocator() : wasted_(0) { }
+
+    CRef alloc(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
+        assert(sizeof(Lit)      == sizeof(uint));
+        assert(sizeof(float)    == sizeof(uint));
+        assert(sizeof(ClauseId) == sizeof(uint));
+        CRef    r = mem.size();
+        mem.growTo(mem.size() + Clause::words(ps.size(), learnt, id != ClauseId_NULL));
+        new (&mem[r]) Clause(learnt, ps, id);
+        return r; }
+
+    Clause&       operator [] (CRef r)       { return *(Clause*)&mem[r]; }
+    const Clause& operator [] (CRef r) const { return *(const Clause*)&mem[r]; }
+
+    void free(CRef r) {
+        const Clause& c = (*this)[r];
+        wasted_ += Clause::words(c.size(), c.learnt(), c.hasId()); }
+    int  size  () const { return mem.size(); }
+    int  wasted() const { return wasted_; }
+
+    void moveTo(ClauseAllocator& to) { mem.moveTo(to.mem); to.wasted_ = wasted_; wasted_ = 0; }
+    void reloc (CRef& r, ClauseAllocator& to) {
+        Clause& c = (*this)[r];
+        if (c.reloced()){ r = c.relocation(); return; }
+        int     n  = Clause::words(c.size(), c.learnt(), c.hasId());
+        CRef    nr = to.mem.size();
+        to.mem.growTo(to.mem.size() + n);
+        for (int i = 0; i < n; i++) to.mem[nr + i] = mem[r + i];
+        c.relocate(nr);
+        r = nr; }
 };
-inline GClause GClause_new(Lit p)     { return GClause((void*)(((intp)index(p) << 1) + 1)); }
-inline GClause GClause_new(Clause* c) { assert(((uintp)c & 1) == 0); return GClause((void*)c); }
-
-#define GClause_NULL GClause_new((Clause*)NULL)
 
 
 //=================================================================================================
@@ -15,6 +15,14 @@
 
 using namespace std;
 
+// Result of a budgeted solve
+enum SatResult
+{
+   UNSAT_RES     = 0,
+   SAT_RES       = 1,
+   UNDECIDED_RES = 2
+};
+
 /********** MiniSAT_Solver **********/
 class SatSolver
 {
@@ -34,8 +42,14 @@ class SatSolver
       }
 
       // Constructing proof model
-      // Return the Var ID of the new Var
-      inline Var newVar() { _solver->newVar(); return _curVar++; }
+      // Return the Var ID of the new Var; the solver only branches on
+      // decision Vars, the others must be implied by them
+      inline Var newVar(bool decision = true) {
+         _solver->newVar(decision); return _curVar++;
+      }
+      void setDecisionVar(Var v, bool decision) {
+         _solver->setDecisionVar(v, decision);
+      }
       // fa/fb = true if it is inverted
       void addAigCNF(Var vf, Var va, bool fa, Var vb, bool fb) {
          vec<Lit> lits;
@@ -65,12 +79,43 @@ class SatSolver
          _solver->addClause(lits); lits.clear();
       }
 
+      // Miter guarded by the activation literal "act": act -> (a ^ b).
+      // Assume "act" to prove a == b, then "retire(act)"; the clauses are
+      // satisfied from then on and freed by the next "collectGarbage()"
+      void addMiterCNF(Var act, Var va, bool fa, Var vb, bool fb) {
+         vec<Lit> lits;
+         Lit la = fa? ~Lit(va): Lit(va);
+         Lit lb = fb? ~Lit(vb): Lit(vb);
+         lits.push(~Lit(act)); lits.push( la); lits.push( lb);
+         _solver->addClause(lits); lits.clear();
+         lits.push(~Lit(act)); lits.push(~la); lits.push(~lb);
+         _solver->addClause(lits); lits.clear();
+      }
+      void retire(Var act) { _solver->addUnit(~Lit(act)); }
+      void collectGarbage() { _solver->garbageCollect(); }
+      // Clauses learnt so far (and top-level units), each followed by
+      // lit_Undef; "importLearnt()" seeds a new solver of the same problem
+      void exportLearnts(vec<Lit>& out) { _solver->exportLearnts(out); }
+      void importLearnt(const vec<Lit>& lits) { _solver->addLearnt(lits); }
+      int nVars() const { return _curVar; }
+      int nClauses() const { return const_cast<Solver*>(_solver)->nClauses(); }
+
       // For incremental proof, use "assumeSolve()"
       void assumeRelease() { _assump.clear(); }
       void assumeProperty(Var prop, bool val) {
          _assump.push(val? Lit(prop): ~Lit(prop));
       }
       bool assumpSolve() { return _solver->solve(_assump); }
+      // Gives up with UNDECIDED_RES after "conflicts" conflicts or
+      // "propagations" propagations; a negative budget means no limit
+      SatResult assumpSolve(int64 conflicts, int64 propagations) {
+         _solver->budgetOff();
+         if (conflicts >= 0) _solver->setConfBudget(conflicts);
+         if (propagations >= 0) _solver->setPropBudget(propagations);
+         lbool res = _solver->solveLimited(_assump);
+         _solver->budgetOff();
+         return res == l_True? SAT_RES: (res == l_False? UNSAT_RES: UNDECIDED_RES);
+      }
 
       // For one time proof, use "solve"
       void assertProperty(Var prop, bool val) {